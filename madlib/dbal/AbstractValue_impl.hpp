@@ -12,3 +12,18 @@
 EXPAND_FOR_ALL_TYPES
 
 #undef EXPAND_TYPE
+
+#define EXPAND_TYPE(T) \
+    T AbstractValue::getAsByID(unsigned int inID, T* inTypeParameter) const { \
+        AbstractValueSPtr value = getValueByID(inID); \
+        AbstractValueSPtr lastDelegate; \
+        \
+        if (!value || !(lastDelegate = value->getValueByID(0))) \
+            throw std::logic_error("Internal type conversion error"); \
+        \
+        return lastDelegate->getAs(inTypeParameter); \
+    }
+
+EXPAND_FOR_ALL_TYPES
+
+#undef EXPAND_TYPE
@@ -56,4 +56,18 @@ protected:
     virtual AbstractValueSPtr mutableClone() const {
         return AbstractValueSPtr();
     }
+    
+    /**
+     * Convert the element with the given ID directly into type T. The default
+     * implementation goes through getValueByID(). Subclasses that can produce
+     * the requested type without creating an intermediate AbstractValue on
+     * the heap should override this function.
+     */
+    #define EXPAND_TYPE(T) \
+        inline virtual T getAsByID(unsigned int inID, \
+            T* /* pure type parameter */) const;
+
+    EXPAND_FOR_ALL_TYPES
+
+    #undef EXPAND_TYPE
 };
@@ -54,6 +54,20 @@ public:
                 // by getValueByID as delegate)
                 return shared_ptr<AnyValue>( new AnyValue(valuePtr) );
         }
+        
+        /**
+         * @brief Convert the current element directly into type T
+         *
+         * Unlike <tt>T value = *iterator</tt>, this does not create a
+         * temporary AnyValue. Depending on the underlying AbstractValue (e.g.,
+         * the argument list of a database function call), no heap allocation
+         * is necessary at all. Use this for scalar arguments and immutable
+         * vectors in transition functions.
+         */
+        template <class T>
+        T getAs() const {
+            return mValue.getAsByID(mCurrentID, static_cast<T*>(NULL));
+        }
             
     private:
         const AbstractValue &mValue;
@@ -154,6 +168,18 @@ protected:
         
         return AbstractValueSPtr();
     };
+    
+    #define EXPAND_TYPE(T) \
+        T getAsByID(unsigned int inID, T* inTypeParameter) const { \
+            if (mDelegate) \
+                return mDelegate->getAsByID(inID, inTypeParameter); \
+            \
+            return AbstractValue::getAsByID(inID, inTypeParameter); \
+        }
+
+    EXPAND_FOR_ALL_TYPES
+
+    #undef EXPAND_TYPE
 
 private:
     /**
@@ -0,0 +1,52 @@
+/* ----------------------------------------------------------------------- *//**
+ *
+ * @file ArrayAdd.hpp
+ *
+ * @brief Element-wise addition of contiguous double-precision storage
+ *
+ *//* ----------------------------------------------------------------------- */
+
+/**
+ * @brief Add contiguous doubles element-wise: \f$ y_i += x_i \f$
+ *
+ * This is the inner loop of merging transition states, which can be several
+ * megabytes large. With SSE2, two pairs of doubles are added per iteration.
+ * Unaligned loads and stores are used, because arrays from the backend are
+ * only guaranteed to be 8-byte aligned.
+ *
+ * @param ioY Pointer to the first element of \f$ y \f$
+ * @param inX Pointer to the first element of \f$ x \f$. The ranges must not
+ *     overlap.
+ * @param inN Number of elements
+ */
+inline void addContiguous(double *ioY, const double *inX, std::size_t inN) {
+    std::size_t i = 0;
+
+#if defined(__SSE2__)
+    for (; i + 4 <= inN; i += 4) {
+        _mm_storeu_pd(ioY + i,
+            _mm_add_pd(_mm_loadu_pd(ioY + i), _mm_loadu_pd(inX + i)));
+        _mm_storeu_pd(ioY + i + 2,
+            _mm_add_pd(_mm_loadu_pd(ioY + i + 2), _mm_loadu_pd(inX + i + 2)));
+    }
+#endif
+
+    for (; i < inN; i++)
+        ioY[i] += inX[i];
+}
+
+/**
+ * @brief Add a range of elements of another array
+ *
+ * Elements \c inBegin, ..., <tt>inBegin + inN - 1</tt> of \c inOther are added
+ * to the elements at the same positions of \c ioArray. Both arrays are
+ * one-dimensional and zero-based, so the range is contiguous.
+ */
+inline void addRange(Array<double> &ioArray,
+    const Array<double> &inOther, std::size_t inBegin, std::size_t inN) {
+
+    if (inBegin + inN > ioArray.size() || inBegin + inN > inOther.size())
+        throw std::out_of_range("Range exceeds array bounds");
+
+    addContiguous(ioArray.data() + inBegin, inOther.data() + inBegin, inN);
+}
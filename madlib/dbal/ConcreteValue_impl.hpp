@@ -153,3 +153,31 @@ inline AbstractValueSPtr ConcreteValue<Array_const<double> >::mutableClone() con
             )
         );
 }
+
+// Single-precision and integer arrays are only used as read-only arguments
+// (e.g., rows of independent variables or the indices of a
+// SparseVector_const), so there is no mutable counterpart.
+template <>
+inline bool ConcreteValue<Array_const<float> >::isMutable() const {
+    return false;
+}
+
+template <>
+inline AbstractValueSPtr ConcreteValue<Array_const<float> >::mutableClone()
+    const {
+    
+    throw std::logic_error("Internal error: Single-precision arrays are "
+        "immutable");
+}
+
+template <>
+inline bool ConcreteValue<Array_const<int32_t> >::isMutable() const {
+    return false;
+}
+
+template <>
+inline AbstractValueSPtr ConcreteValue<Array_const<int32_t> >::mutableClone()
+    const {
+    
+    throw std::logic_error("Internal error: Integer arrays are immutable");
+}
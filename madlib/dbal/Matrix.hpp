@@ -27,7 +27,7 @@ public:
         using arma::access;
         using arma::Mat;
         
-        access::rw(Mat<eT>::mem) = mMemoryHandle->ptr();
+        access::rw(Mat<eT>::mem) = static_cast<eT*>(mMemoryHandle->ptr());
     }
 
     inline Matrix(
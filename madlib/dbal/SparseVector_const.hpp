@@ -0,0 +1,99 @@
+/* ----------------------------------------------------------------------- *//**
+ *
+ * @file SparseVector_const.hpp
+ *
+ * @brief MADlib immutable sparse vector class -- a view on an index array and
+ *        a value array
+ *
+ *//* ----------------------------------------------------------------------- */
+
+/**
+ * @brief Immutable sparse vector given by index/value pairs
+ *
+ * The vector has \c n_elem elements, of which only the \c n_nonzero elements
+ * at positions <tt>index(0), ..., index(n_nonzero - 1)</tt> may be non-zero.
+ * Indices are passed one-based (as SQL arrays are), have to be strictly
+ * increasing, and are validated in the constructor. No data is copied: Both
+ * arrays keep their memory handles.
+ */
+class SparseVector_const {
+public:
+    inline SparseVector_const(
+        const Array_const<int32_t> &inIndices,
+        const Array_const<double> &inValues,
+        const uint32_t inNumElem)
+        : mIndices(inIndices),
+          mValues(inValues),
+          n_elem(inNumElem),
+          n_nonzero(static_cast<uint32_t>(inValues.size())) {
+
+        if (inIndices.size() != inValues.size())
+            throw std::invalid_argument("Sparse vector has different number "
+                "of indices and values.");
+
+        const int32_t *indices = inIndices.data();
+        int32_t previous = 0;
+        for (uint32_t k = 0; k < n_nonzero; k++) {
+            if (indices[k] <= previous)
+                throw std::invalid_argument("Sparse vector indices must be "
+                    "positive and strictly increasing.");
+            if (static_cast<uint32_t>(indices[k]) > n_elem)
+                throw std::out_of_range("Sparse vector index exceeds "
+                    "dimension.");
+            previous = indices[k];
+        }
+    }
+
+    /**
+     * @brief Zero-based position of the k-th stored element
+     */
+    inline uint32_t index(const uint32_t inK) const {
+        return static_cast<uint32_t>(mIndices.data()[inK]) - 1;
+    }
+
+    /**
+     * @brief Value of the k-th stored element
+     */
+    inline double value(const uint32_t inK) const {
+        return mValues.data()[inK];
+    }
+
+    /**
+     * @brief Dot product with a dense vector of length \c n_elem
+     */
+    inline double dot(const double *inDense) const {
+        const int32_t *indices = mIndices.data();
+        const double *values = mValues.data();
+        double result = 0;
+        for (uint32_t k = 0; k < n_nonzero; k++)
+            result += values[k] * inDense[indices[k] - 1];
+        return result;
+    }
+
+    /**
+     * @brief Add a multiple of this vector to a dense vector of length
+     *     \c n_elem
+     */
+    inline void addTo(double *ioDense, const double inAlpha = 1.) const {
+        const int32_t *indices = mIndices.data();
+        const double *values = mValues.data();
+        for (uint32_t k = 0; k < n_nonzero; k++)
+            ioDense[indices[k] - 1] += inAlpha * values[k];
+    }
+
+    /**
+     * @brief Write this vector into a dense vector of length \c n_elem
+     */
+    inline void toDense(double *outDense) const {
+        std::fill(outDense, outDense + n_elem, 0.);
+        addTo(outDense);
+    }
+
+protected:
+    Array_const<int32_t> mIndices;
+    Array_const<double> mValues;
+
+public:
+    const uint32_t n_elem;
+    const uint32_t n_nonzero;
+};
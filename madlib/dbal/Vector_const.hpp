@@ -101,6 +101,10 @@ public:
     inline operator const T<eT>&() const {
         return mVector;
     }
+    
+    inline const eT *memptr() const {
+        return mVector.memptr();
+    }
         
     /**
      * @internal This function accesses internal elements of arma::mat.
@@ -22,6 +22,11 @@
 // Matrix, Vector
 #include <armadillo>
 
+// Vectorized element-wise addition (ArrayAdd)
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 // All sources need to (implicitly or explicitly) include madlib.hpp, so we also
 // include it here
 
@@ -45,6 +50,8 @@
     EXPAND_FOR_PRIMITIVE_TYPES \
     EXPAND_TYPE(Array<double>) \
     EXPAND_TYPE(Array_const<double>) \
+    EXPAND_TYPE(Array_const<float>) \
+    EXPAND_TYPE(Array_const<int32_t>) \
     EXPAND_TYPE(DoubleCol) \
     EXPAND_TYPE(DoubleCol_const) \
     EXPAND_TYPE(DoubleMat) \
@@ -78,6 +85,7 @@ template <typename T, std::size_t NumDims = 1> class Array_const;
 template <template <class> class T, typename eT> class Vector;
 template <template <class> class T, typename eT> class Vector_const;
 template <typename eT> class Matrix;
+class SparseVector_const;
 
 typedef Matrix<double> DoubleMat;
 typedef Vector<arma::Col, double> DoubleCol;
@@ -114,6 +122,11 @@ typedef ConcreteValue<AnyValueVector> ConcreteRecord;
 #include <madlib/dbal/Matrix.hpp>
 #include <madlib/dbal/Vector.hpp>
 #include <madlib/dbal/Vector_const.hpp>
+#include <madlib/dbal/SparseVector_const.hpp>
+
+// Functions on Arrays
+
+#include <madlib/dbal/ArrayAdd.hpp>
 
 } // namespace dbal
 
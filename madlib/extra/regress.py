@@ -14,7 +14,8 @@ import plpy
 
 def __runIterativeAlg(stateType, initialState, source, updateExpr,
     terminateExpr, cyclesPerIteration, maxNumIterations,
-    returnExpr = "st.state"):
+    returnExpr = "st.state", modelName = None, optimizer = None,
+    warmStartExpr = "{state}", checkpointConnection = None):
     """
     Driver for an iterative algorithm
     
@@ -48,6 +49,20 @@ def __runIterativeAlg(stateType, initialState, source, updateExpr,
         a field <tt>coefficients</tt>, and this should be returned as the result
         of the algorithm, pass <tt>"{state}.coefficients"</tt> here. The
         replacement field <tt>"{iteration}"</tt> can also be used.
+    @param modelName If not None, the states are kept under this name in the
+        table <tt>_madlib_model_state</tt> (see __loadModelState() and
+        __saveModelState()), and the algorithm warm-starts or resumes from a
+        model of the same name.
+    @param optimizer Name of the algorithm that produces the states. Stored
+        states can only be used by the same algorithm.
+    @param warmStartExpr SQL expression that transforms the final state of an
+        earlier run into the initial state of a new run (warm start). Use
+        "{state}" to refer to the stored state.
+    @param checkpointConnection If not None (and <tt>modelName</tt> is given),
+        a dblink connection string. The states are then written through this
+        separate connection after every completed iteration, and committed
+        there, so that a cancelled or crashed run can be resumed from its last
+        completed iteration (see __saveModelState()).
     """
 
     state = "(st.state)"
@@ -105,18 +120,40 @@ def __runIterativeAlg(stateType, initialState, source, updateExpr,
         SET client_min_messages = {oldMsgLevel};
         """.format(**locals()))
     
+    checkpoint = modelName is not None and checkpointConnection is not None
+    if checkpoint:
+        oldFloatDigits = __connectCheckpoint(checkpointConnection)
+    
     iteration = 0
-    plpy.execute("""
-        INSERT INTO _madlib_iterative_alg VALUES ({iteration}, {initialState})
-        """.format(**locals()))
+    if modelName is None:
+        plpy.execute("""
+            INSERT INTO _madlib_iterative_alg VALUES ({iteration}, {initialState})
+            """.format(**locals()))
+    else:
+        iteration = __loadModelState(modelName, optimizer, initialState,
+            warmStartExpr, checkpoint)
+    lastIteration = iteration + cyclesPerIteration * maxNumIterations
+    
+    hasConverged = False
     while True:
         iteration = iteration + 1
         plpy.execute(updateSQL.format(**locals()))
-        if iteration > cyclesPerIteration and (
-            iteration >= cyclesPerIteration * maxNumIterations or
-            plpy.execute(terminateSQL.format(**locals()))[0]['should_terminate']
-                == True):
-            break
+        if iteration > cyclesPerIteration:
+            if plpy.execute(terminateSQL.format(**locals()))[0]['should_terminate'] \
+                    == True:
+                hasConverged = True
+                break
+            if iteration >= lastIteration:
+                break
+        if checkpoint and iteration % cyclesPerIteration == 0:
+            __saveModelState(modelName, optimizer, iteration,
+                cyclesPerIteration, False, True)
+    
+    if modelName is not None:
+        __saveModelState(modelName, optimizer, iteration, cyclesPerIteration,
+            hasConverged or terminateExpr == "FALSE", checkpoint)
+    if checkpoint:
+        __disconnectCheckpoint(oldFloatDigits)
     
     # FIXME: Returning the result set from Python code means that values
     # pass through Python (and there is a potential loss of precision by
@@ -127,6 +164,217 @@ def __runIterativeAlg(stateType, initialState, source, updateExpr,
     return returnValue
 
 
+def __loadModelState(modelName, optimizer, initialState, warmStartExpr,
+    checkpoint):
+    """
+    Fill _madlib_iterative_alg with the stored states of a named model
+    
+    Table <tt>_madlib_model_state</tt> contains, for each model name, either
+    the final state of the last completed run (<tt>is_final</tt> is true) or
+    the last states of an unfinished run (<tt>is_final</tt> is false):
+    - If there are states of an unfinished run, they are copied with their
+      iteration numbers, and the run resumes after the last of them.
+    - Otherwise, if there is a final state, the new run starts with
+      <tt>warmStartExpr</tt> applied to it (warm start).
+    - Otherwise, the new run starts with <tt>initialState</tt>.
+    
+    If <tt>checkpoint</tt> is true, the table is created through the
+    checkpoint connection, so that it is committed before the first
+    checkpoint is written.
+    
+    @return The number of the last iteration in _madlib_iterative_alg
+    """
+    
+    oldMsgLevel = plpy.execute("SHOW client_min_messages")[0]['client_min_messages']
+    if len(plpy.execute("""
+            SELECT 1 FROM pg_class
+            WHERE relname = '_madlib_model_state' AND pg_table_is_visible(oid)
+            """)) == 0:
+        createSQL = """
+            CREATE TABLE _madlib_model_state (
+                model_name VARCHAR,
+                optimizer VARCHAR,
+                is_final BOOLEAN,
+                iteration INTEGER,
+                state FLOAT8[],
+                PRIMARY KEY (model_name, is_final, iteration)
+            )
+            """
+        if checkpoint:
+            __checkpointExec(createSQL)
+        else:
+            plpy.execute("""
+                SET client_min_messages = error;
+                {createSQL};
+                SET client_min_messages = {oldMsgLevel};
+                """.format(createSQL = createSQL, oldMsgLevel = oldMsgLevel))
+    
+    plan = plpy.prepare("""
+        SELECT optimizer, is_final, max(iteration) AS iteration
+        FROM _madlib_model_state
+        WHERE model_name = $1
+        GROUP BY optimizer, is_final
+        ORDER BY is_final
+        """, ["VARCHAR"])
+    stored = plpy.execute(plan, [modelName])
+    
+    if len(stored) == 0:
+        plpy.execute("""
+            INSERT INTO _madlib_iterative_alg VALUES (0, {initialState})
+            """.format(initialState = initialState))
+        return 0
+    
+    if stored[0]['optimizer'] != optimizer:
+        plpy.error("Model '{modelName}' was computed with optimizer "
+            "'{storedOptimizer}', not '{optimizer}'".format(
+                modelName = modelName, optimizer = optimizer,
+                storedOptimizer = stored[0]['optimizer']))
+    
+    if not stored[0]['is_final']:
+        plan = plpy.prepare("""
+            INSERT INTO _madlib_iterative_alg
+            SELECT iteration, state
+            FROM _madlib_model_state
+            WHERE model_name = $1 AND NOT is_final
+            """, ["VARCHAR"])
+        plpy.execute(plan, [modelName])
+        return stored[0]['iteration']
+    
+    plan = plpy.prepare("""
+        INSERT INTO _madlib_iterative_alg
+        SELECT 0, {warmStartExpr}
+        FROM _madlib_model_state AS ms
+        WHERE model_name = $1 AND is_final
+        """.format(warmStartExpr = warmStartExpr.format(state = "(ms.state)")),
+        ["VARCHAR"])
+    plpy.execute(plan, [modelName])
+    return 0
+
+
+def __saveModelState(modelName, optimizer, iteration, cyclesPerIteration,
+    isFinal, checkpoint):
+    """
+    Store the last states in _madlib_iterative_alg under a model name
+    
+    If the run is complete, only the last state is stored as the final state,
+    and all earlier states of the model are removed. Otherwise, the last
+    <tt>cyclesPerIteration + 1</tt> states are stored, which is what the
+    termination test needs when the run is resumed.
+    
+    Without <tt>checkpoint</tt>, the states are written in the current
+    transaction. They become visible to other sessions when it commits, and
+    they are rolled back if the run is cancelled.
+    
+    With <tt>checkpoint</tt>, the states are written through the dblink
+    connection opened by __connectCheckpoint(), which commits them right away.
+    They hence survive if the calling transaction is aborted later. The
+    current transaction never modifies _madlib_model_state in this mode, so
+    the checkpoint connection cannot wait for locks held by it. (Runs with
+    and without checkpoints of the same model must not be mixed within one
+    transaction.) The states are sent as text, with extra_float_digits set so
+    that they are restored exactly.
+    """
+    
+    firstIteration = iteration if isFinal else iteration - cyclesPerIteration
+    if checkpoint:
+        plan = plpy.prepare("""
+            SELECT
+                'DELETE FROM _madlib_model_state WHERE model_name = '
+                || quote_literal($1) || '; '
+                || 'INSERT INTO _madlib_model_state '
+                || array_to_string(ARRAY(
+                    SELECT
+                        'SELECT ' || quote_literal($1) || '::VARCHAR, '
+                        || quote_literal($2) || '::VARCHAR, '
+                        || CASE WHEN $3 THEN 'TRUE' ELSE 'FALSE' END || ', '
+                        || iteration || ', '
+                        || coalesce(quote_literal(
+                            '{' || array_to_string(state, ',') || '}'), 'NULL')
+                        || '::FLOAT8[]'
+                    FROM _madlib_iterative_alg
+                    WHERE iteration >= $4
+                    ORDER BY iteration
+                ), ' UNION ALL ') AS sql
+            """, ["VARCHAR", "VARCHAR", "BOOLEAN", "INTEGER"])
+        __checkpointExec(plpy.execute(plan,
+            [modelName, optimizer, isFinal, firstIteration])[0]['sql'])
+        return
+    
+    plan = plpy.prepare("""
+        DELETE FROM _madlib_model_state WHERE model_name = $1
+        """, ["VARCHAR"])
+    plpy.execute(plan, [modelName])
+    
+    plan = plpy.prepare("""
+        INSERT INTO _madlib_model_state
+        SELECT $1, $2, $3, iteration, state
+        FROM _madlib_iterative_alg
+        WHERE iteration >= $4
+        """, ["VARCHAR", "VARCHAR", "BOOLEAN", "INTEGER"])
+    plpy.execute(plan, [modelName, optimizer, isFinal, firstIteration])
+
+
+# Name of the dblink connection used by __checkpointExec()
+__checkpointConnectionName = "madlib_checkpoint"
+
+
+def __connectCheckpoint(checkpointConnection):
+    """
+    Open the dblink connection for checkpoints
+    
+    A connection left open by an earlier call that failed is closed first.
+    Float values are printed with all significant digits while the connection
+    is open.
+    
+    @return The previous value of extra_float_digits, to be passed to
+        __disconnectCheckpoint()
+    """
+    
+    plan = plpy.prepare("""
+        SELECT coalesce($1 = ANY(dblink_get_connections()), FALSE)
+            AS is_open
+        """, ["TEXT"])
+    if plpy.execute(plan, [__checkpointConnectionName])[0]['is_open']:
+        plan = plpy.prepare("SELECT dblink_disconnect($1)", ["TEXT"])
+        plpy.execute(plan, [__checkpointConnectionName])
+    plan = plpy.prepare("SELECT dblink_connect($1, $2)", ["TEXT", "TEXT"])
+    plpy.execute(plan, [__checkpointConnectionName, checkpointConnection])
+    
+    oldFloatDigits = plpy.execute("SHOW extra_float_digits")[0]['extra_float_digits']
+    plpy.execute("SET extra_float_digits = 3")
+    return oldFloatDigits
+
+
+def __disconnectCheckpoint(oldFloatDigits):
+    """
+    Close the dblink connection opened by __connectCheckpoint()
+    """
+    
+    plpy.execute("SET extra_float_digits = {oldFloatDigits}".format(
+        oldFloatDigits = oldFloatDigits))
+    plan = plpy.prepare("SELECT dblink_disconnect($1)", ["TEXT"])
+    plpy.execute(plan, [__checkpointConnectionName])
+
+
+def __checkpointExec(sql):
+    """
+    Execute SQL statements through the checkpoint connection
+    
+    dblink_exec() runs all statements of one call in a single transaction,
+    which is committed when the call returns.
+    """
+    
+    plan = plpy.prepare("SELECT dblink_exec($1, $2)", ["TEXT", "TEXT"])
+    plpy.execute(plan, [__checkpointConnectionName, sql])
+
+
+# Warm-start expression that sets the iteration counter (the first element of
+# the state) to 0. The conjugate-gradient method then restarts with the
+# gradient on the new data, but keeps the coefficients. L-BFGS also has to
+# reset its trial point, see _logreg_lbfgs_warm_start().
+__restartExpr = "array_cat(ARRAY[0]::FLOAT8[], {state}[2:array_upper({state}, 1)])"
+
+
 def __cg_logregr_coef(**kwargs):
     """
     Logistic regression algorithm with the conjugate-gradient method
@@ -147,7 +395,7 @@ def __cg_logregr_coef(**kwargs):
     updateExpr = """
         logreg_cg_step(
             {{sourceAlias}}.{depColumn},
-            {{sourceAlias}}.{indepColumn},
+            {indepExpr},
             {{state}}
         )
         """.format(**kwargs)
@@ -164,7 +412,123 @@ def __cg_logregr_coef(**kwargs):
     maxNumIterations = kwargs['numIterations']
     returnExpr = "_logreg_cg_coef({state})"
     return __runIterativeAlg(stateType, initialState, source, updateExpr,
-        terminateExpr, cyclesPerIteration, maxNumIterations, returnExpr)
+        terminateExpr, cyclesPerIteration, maxNumIterations, returnExpr,
+        modelName = kwargs['modelName'], optimizer = 'cg',
+        checkpointConnection = kwargs['checkpointConnection'],
+        warmStartExpr = __restartExpr)
+
+
+def __fcg_logregr_coef(**kwargs):
+    """
+    Logistic regression algorithm with the fused conjugate-gradient method
+    
+    The parameters are the same as for compute_logregr_coef(), except that
+    <tt>optimizer</tt> should not be set. In contrast to __cg_logregr_coef(),
+    each iteration needs only one scan of the source relation.
+    """
+    
+    stateType = "FLOAT8[]"
+    initialState = "NULL"
+    source = kwargs['source']
+    updateExpr = """
+        logreg_fcg_step(
+            {{sourceAlias}}.{depColumn},
+            {indepExpr},
+            {{state}}
+        )
+        """.format(**kwargs)
+    if kwargs['precision'] == 0.:
+        terminateExpr = "FALSE"
+    else:
+        terminateExpr = """
+            _logreg_fcg_step_distance({{newState}}, {{oldState}}) < {precision}
+            """.format(**kwargs)
+    
+    cyclesPerIteration = 1
+    maxNumIterations = kwargs['numIterations']
+    returnExpr = "_logreg_fcg_coef({state})"
+    return __runIterativeAlg(stateType, initialState, source, updateExpr,
+        terminateExpr, cyclesPerIteration, maxNumIterations, returnExpr,
+        modelName = kwargs['modelName'], optimizer = 'fcg',
+        checkpointConnection = kwargs['checkpointConnection'])
+
+
+def __lbfgs_logregr_coef(**kwargs):
+    """
+    Logistic regression algorithm with the limited-memory BFGS method
+    
+    The parameters are the same as for compute_logregr_coef(), except that
+    <tt>optimizer</tt> should not be set. Each iteration needs one scan of the
+    source relation. Iterations that reduce the step size along the current
+    search direction also count towards <tt>numIterations</tt>.
+    """
+    
+    stateType = "FLOAT8[]"
+    initialState = "NULL"
+    source = kwargs['source']
+    if kwargs['historySize'] > 0:
+        historySizeArg = ", {historySize}".format(**kwargs)
+    else:
+        historySizeArg = ""
+    updateExpr = """
+        logreg_lbfgs_step(
+            {{sourceAlias}}.{depColumn},
+            {indepExpr},
+            {{state}}{historySizeArg}
+        )
+        """.format(historySizeArg = historySizeArg, **kwargs)
+    if kwargs['precision'] == 0.:
+        terminateExpr = "FALSE"
+    else:
+        terminateExpr = """
+            _logreg_lbfgs_step_distance({{newState}}, {{oldState}}) < {precision}
+            """.format(**kwargs)
+    
+    cyclesPerIteration = 1
+    maxNumIterations = kwargs['numIterations']
+    returnExpr = "_logreg_lbfgs_coef({state})"
+    return __runIterativeAlg(stateType, initialState, source, updateExpr,
+        terminateExpr, cyclesPerIteration, maxNumIterations, returnExpr,
+        modelName = kwargs['modelName'], optimizer = 'lbfgs',
+        checkpointConnection = kwargs['checkpointConnection'],
+        warmStartExpr = "_logreg_lbfgs_warm_start({state})")
+
+
+def __sgd_logregr_coef(**kwargs):
+    """
+    Logistic regression algorithm with stochastic gradient descent
+    
+    The parameters are the same as for compute_logregr_coef(), except that
+    <tt>optimizer</tt> should not be set. Each iteration is one pass over the
+    source relation, so <tt>numIterations</tt> is the number of epochs.
+    """
+    
+    stateType = "FLOAT8[]"
+    initialState = "NULL"
+    source = kwargs['source']
+    updateExpr = """
+        logreg_sgd_step(
+            {{sourceAlias}}.{depColumn},
+            {indepExpr},
+            {{state}},
+            ({stepSize})::DOUBLE PRECISION,
+            ({stepDecay})::DOUBLE PRECISION
+        )
+        """.format(**kwargs)
+    if kwargs['precision'] == 0.:
+        terminateExpr = "FALSE"
+    else:
+        terminateExpr = """
+            _logreg_sgd_step_distance({{newState}}, {{oldState}}) < {precision}
+            """.format(**kwargs)
+    
+    cyclesPerIteration = 1
+    maxNumIterations = kwargs['numIterations']
+    returnExpr = "_logreg_sgd_coef({state})"
+    return __runIterativeAlg(stateType, initialState, source, updateExpr,
+        terminateExpr, cyclesPerIteration, maxNumIterations, returnExpr,
+        modelName = kwargs['modelName'], optimizer = 'sgd',
+        checkpointConnection = kwargs['checkpointConnection'])
 
 
 def __irls__logregr_coef(**kwargs):
@@ -180,13 +544,17 @@ def __irls__logregr_coef(**kwargs):
     stateType = "FLOAT8[]"
     initialState = "NULL"
     source = kwargs['source']
+    if kwargs['batchSize'] > 1:
+        batchSizeArg = ", {batchSize}".format(**kwargs)
+    else:
+        batchSizeArg = ""
     updateExpr = """
         logreg_irls_step(
             {{sourceAlias}}.{depColumn},
-            {{sourceAlias}}.{indepColumn},
-            {{state}}
+            {indepExpr},
+            {{state}}{batchSizeArg}
         )
-        """.format(**kwargs)
+        """.format(batchSizeArg = batchSizeArg, **kwargs)
     if kwargs['precision'] == 0.:
         terminateExpr = "FALSE"
     else:
@@ -198,7 +566,9 @@ def __irls__logregr_coef(**kwargs):
     maxNumIterations = kwargs['numIterations']
     returnExpr = "_logreg_irls_coef({state})"
     return __runIterativeAlg(stateType, initialState, source, updateExpr,
-        terminateExpr, cyclesPerIteration, maxNumIterations, returnExpr)
+        terminateExpr, cyclesPerIteration, maxNumIterations, returnExpr,
+        modelName = kwargs['modelName'], optimizer = 'irls',
+        checkpointConnection = kwargs['checkpointConnection'])
     
 
 def compute_logregr_coef(**kwargs):
@@ -212,18 +582,56 @@ def compute_logregr_coef(**kwargs):
     @param source Name of relation containing the training data
     @param depColumn Name of dependent column in training data (of type BOOLEAN)
     @param indepColumn Name of independent column in training data (of type
-           DOUBLE PRECISION[])
+           DOUBLE PRECISION[] or REAL[]). For sparse rows, this column contains the
+           values of the non-zero elements.
     
     Optionally also provide the following:
     @param optimizer Name of the optimizer. 'newton' or 'irls': Iteratively
-        reweighted least squares, 'cg': conjugate gradient (default = 'irls')
-    @param numIterations Maximum number of iterations (default = 20)
+        reweighted least squares, 'cg': conjugate gradient, 'fcg': conjugate
+        gradient with one scan per iteration, 'lbfgs': limited-memory BFGS,
+        'sgd': stochastic gradient descent (default = 'irls')
+    @param numIterations Maximum number of iterations (default = 20). For
+           stochastic gradient descent, this is the number of passes over
+           the data, and 1 to 3 are usually sufficient.
     @param precision Terminate if two consecutive iterations have a difference 
            in the log-likelihood of less than <tt>precision</tt>. In other
            words, we terminate if the objective function value has converged.
            If this parameter is 0.0, then the algorithm will not check for
            convergence and only terminate after <tt>numIterations</tt>
            iterations.
+    @param batchSize Number of rows that the IRLS transition function
+           collects before adding them to its state in one block (default = 0,
+           i.e., rows are added one by one). Values between 64 and 256 allow
+           using BLAS level-3 routines. Ignored by the conjugate-gradient
+           method.
+    @param historySize Number of correction pairs that the limited-memory
+           BFGS method keeps (default = 0, i.e., 10 pairs). Ignored by the
+           other methods.
+    @param stepSize Initial step size of stochastic gradient descent
+           (default = 0.1)
+    @param stepDecay Decay of the step size of stochastic gradient descent:
+           The step size for the t-th row is
+           <tt>stepSize / (1 + stepDecay * t)</tt> (default = 0.001). With 0,
+           the step size is constant.
+    
+    @param indexColumn Name of the column containing the one-based positions
+           of the non-zero elements (of type INTEGER[]), if rows are sparse
+           (default = None, i.e., rows are dense)
+    @param numFeatures Number of independent variables. Required if
+           <tt>indexColumn</tt> is given.
+    
+    @param modelName Name under which the states are kept in table
+           <tt>_madlib_model_state</tt> (default = None, i.e., states are not
+           kept). If a previous run with the same name did not converge
+           within <tt>numIterations</tt> iterations, the run resumes from its
+           last iteration. If it did converge, the new run starts with its
+           coefficients (warm start). See __saveModelState() for when states
+           become durable.
+    @param checkpointConnection dblink connection string (default = None).
+           If given together with <tt>modelName</tt>, the states are
+           committed through this connection after every iteration, so that
+           a cancelled or crashed run resumes from its last completed
+           iteration. Requires the dblink module.
     
     @return array with coefficients in case of convergence, otherwise None
     
@@ -234,12 +642,125 @@ def compute_logregr_coef(**kwargs):
         kwargs.update(numIterations = 20)
     if not 'precision' in kwargs:
         kwargs.update(precision = 0.0001)
+    if not 'batchSize' in kwargs or kwargs['batchSize'] is None:
+        kwargs.update(batchSize = 0)
+    if not 'historySize' in kwargs or kwargs['historySize'] is None:
+        kwargs.update(historySize = 0)
+    if not 'stepSize' in kwargs or kwargs['stepSize'] is None:
+        kwargs.update(stepSize = 0.1)
+    if not 'stepDecay' in kwargs or kwargs['stepDecay'] is None:
+        kwargs.update(stepDecay = 0.001)
+    if not 'modelName' in kwargs:
+        kwargs.update(modelName = None)
+    if not 'checkpointConnection' in kwargs:
+        kwargs.update(checkpointConnection = None)
+    if not 'indexColumn' in kwargs:
+        kwargs.update(indexColumn = None)
+    
+    # "{sourceAlias}" is substituted by __runIterativeAlg
+    if kwargs['indexColumn'] is None:
+        kwargs.update(indepExpr = "{{sourceAlias}}.{indepColumn}".format(
+            **kwargs))
+    else:
+        if not 'numFeatures' in kwargs or kwargs['numFeatures'] is None \
+            or kwargs['numFeatures'] < 0:
+            plpy.error("Number of independent variables must be given for "
+                "sparse rows.")
+        kwargs.update(indepExpr = """
+            {{sourceAlias}}.{indexColumn},
+            {{sourceAlias}}.{indepColumn},
+            {numFeatures}""".format(**kwargs))
         
     if kwargs['optimizer'] == 'cg':
         return __cg_logregr_coef(**kwargs)
+    elif kwargs['optimizer'] == 'fcg':
+        return __fcg_logregr_coef(**kwargs)
+    elif kwargs['optimizer'] == 'lbfgs':
+        return __lbfgs_logregr_coef(**kwargs)
+    elif kwargs['optimizer'] == 'sgd':
+        return __sgd_logregr_coef(**kwargs)
     elif kwargs['optimizer'] in ['irls', 'newton']:
         return __irls__logregr_coef(**kwargs)
     else:
-        plpy.error("Unknown optimizer requested. Must be 'newton'/'irls' or 'cg'")
+        plpy.error("Unknown optimizer requested. Must be 'newton'/'irls', 'cg', 'fcg', 'lbfgs', or 'sgd'")
     
     return None
+
+
+def compute_mlogregr_coef(**kwargs):
+    """
+    Compute multinomial logistic regression coefficients
+    
+    All categories are trained together, so each iteration is a single scan
+    of the source relation. See multilogistic.cpp for the method.
+    
+    @param source Name of relation containing the training data
+    @param depColumn Name of dependent column in training data (of type
+           INTEGER, with values between 0 and <tt>numCategories</tt> - 1)
+    @param indepColumn Name of independent column in training data (of type
+           DOUBLE PRECISION[] or REAL[]). For sparse rows, this column contains
+           the values of the non-zero elements.
+    @param numCategories Number of categories
+    
+    Optionally also provide the following:
+    @param numIterations Maximum number of iterations (default = 20)
+    @param precision Terminate if two consecutive iterations have a difference 
+           in the log-likelihood of less than <tt>precision</tt>. If this
+           parameter is 0.0, then the algorithm will not check for
+           convergence and only terminate after <tt>numIterations</tt>
+           iterations.
+    @param indexColumn, numFeatures As for compute_logregr_coef()
+    @param modelName, checkpointConnection As for compute_logregr_coef()
+    
+    @return array with the coefficients of all categories one after another
+    """
+    if not 'numIterations' in kwargs:
+        kwargs.update(numIterations = 20)
+    if not 'precision' in kwargs:
+        kwargs.update(precision = 0.0001)
+    if not 'modelName' in kwargs:
+        kwargs.update(modelName = None)
+    if not 'checkpointConnection' in kwargs:
+        kwargs.update(checkpointConnection = None)
+    if not 'indexColumn' in kwargs:
+        kwargs.update(indexColumn = None)
+    if kwargs['numCategories'] is None or kwargs['numCategories'] < 2:
+        plpy.error("Number of categories must be at least 2.")
+    
+    if kwargs['indexColumn'] is None:
+        indepExpr = "{{sourceAlias}}.{indepColumn}".format(**kwargs)
+    else:
+        if not 'numFeatures' in kwargs or kwargs['numFeatures'] is None \
+            or kwargs['numFeatures'] < 0:
+            plpy.error("Number of independent variables must be given for "
+                "sparse rows.")
+        indepExpr = """
+            {{sourceAlias}}.{indexColumn},
+            {{sourceAlias}}.{indepColumn},
+            {numFeatures}""".format(**kwargs)
+    
+    stateType = "FLOAT8[]"
+    initialState = "NULL"
+    source = kwargs['source']
+    updateExpr = """
+        mlogreg_step(
+            {{sourceAlias}}.{depColumn},
+            {indepExpr},
+            {{state}},
+            {numCategories}
+        )
+        """.format(indepExpr = indepExpr, **kwargs)
+    if kwargs['precision'] == 0.:
+        terminateExpr = "FALSE"
+    else:
+        terminateExpr = """
+            _mlogreg_step_distance({{newState}}, {{oldState}}) < {precision}
+            """.format(**kwargs)
+    
+    cyclesPerIteration = 1
+    maxNumIterations = kwargs['numIterations']
+    returnExpr = "_mlogreg_coef({state})"
+    return __runIterativeAlg(stateType, initialState, source, updateExpr,
+        terminateExpr, cyclesPerIteration, maxNumIterations, returnExpr,
+        modelName = kwargs['modelName'], optimizer = 'mlogreg',
+        checkpointConnection = kwargs['checkpointConnection'])
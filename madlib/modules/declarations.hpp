@@ -24,27 +24,97 @@
  * name implementing the UDF.
  */
 
+// prob/chisquared.hpp
+DECLARE_UDF(prob, chi_squared_cdf)
+DECLARE_UDF(prob, chi_squared_cdf_array)
+DECLARE_UDF(prob, chi_squared_quantile)
+DECLARE_UDF(prob, chi_squared_quantile_array)
+
+// prob/fisher.hpp
+DECLARE_UDF(prob, fisher_f_cdf)
+DECLARE_UDF(prob, fisher_f_cdf_array)
+DECLARE_UDF(prob, fisher_f_quantile)
+DECLARE_UDF(prob, fisher_f_quantile_array)
+
+// prob/normal.hpp
+DECLARE_UDF(prob, normal_cdf)
+DECLARE_UDF(prob, normal_cdf_array)
+DECLARE_UDF(prob, normal_quantile)
+DECLARE_UDF(prob, normal_quantile_array)
+
 // prob/student.hpp
 DECLARE_UDF(prob, student_t_cdf)
+DECLARE_UDF(prob, student_t_cdf_array)
+DECLARE_UDF(prob, student_t_quantile)
+DECLARE_UDF(prob, student_t_quantile_array)
 
 // regress/linear.hpp
 DECLARE_UDF_EXT(linreg_trans, regress, LinearRegression::transition)
+DECLARE_UDF_EXT(linreg_float_trans, regress, LinearRegression::floatTransition)
+DECLARE_UDF_EXT(linreg_sparse_trans, regress, LinearRegression::sparseTransition)
 DECLARE_UDF_EXT(linreg_prelim, regress, LinearRegression::preliminary)
 
 DECLARE_UDF_EXT(linreg_coef_final, regress, LinearRegression::coefFinal)
 DECLARE_UDF_EXT(linreg_r2_final, regress, LinearRegression::RSquareFinal)
 DECLARE_UDF_EXT(linreg_tstats_final, regress, LinearRegression::tStatsFinal)
 DECLARE_UDF_EXT(linreg_pvalues_final, regress, LinearRegression::pValuesFinal)
+DECLARE_UDF_EXT(linreg_final, regress, LinearRegression::statsFinal)
     
 // regress/logistic.hpp
 DECLARE_UDF_EXT(logreg_cg_step_trans, regress, LogisticRegressionCG::transition)
+DECLARE_UDF_EXT(logreg_cg_step_float_trans, regress, LogisticRegressionCG::floatTransition)
+DECLARE_UDF_EXT(logreg_cg_step_sparse_trans, regress, LogisticRegressionCG::sparseTransition)
 DECLARE_UDF_EXT(logreg_cg_step_prelim, regress, LogisticRegressionCG::preliminary)
 DECLARE_UDF_EXT(logreg_cg_step_final, regress, LogisticRegressionCG::final)
 DECLARE_UDF_EXT(_logreg_cg_step_distance, regress, LogisticRegressionCG::distance)
 DECLARE_UDF_EXT(_logreg_cg_coef, regress, LogisticRegressionCG::coef)
 
+DECLARE_UDF_EXT(logreg_fcg_step_trans, regress, LogisticRegressionFCG::transition)
+DECLARE_UDF_EXT(logreg_fcg_step_float_trans, regress, LogisticRegressionFCG::floatTransition)
+DECLARE_UDF_EXT(logreg_fcg_step_sparse_trans, regress, LogisticRegressionFCG::sparseTransition)
+DECLARE_UDF_EXT(logreg_fcg_step_prelim, regress, LogisticRegressionFCG::preliminary)
+DECLARE_UDF_EXT(logreg_fcg_step_final, regress, LogisticRegressionFCG::final)
+DECLARE_UDF_EXT(_logreg_fcg_step_distance, regress, LogisticRegressionFCG::distance)
+DECLARE_UDF_EXT(_logreg_fcg_coef, regress, LogisticRegressionFCG::coef)
+
+DECLARE_UDF_EXT(logreg_lbfgs_step_trans, regress, LogisticRegressionLBFGS::transition)
+DECLARE_UDF_EXT(logreg_lbfgs_step_float_trans, regress, LogisticRegressionLBFGS::floatTransition)
+DECLARE_UDF_EXT(logreg_lbfgs_step_sparse_trans, regress, LogisticRegressionLBFGS::sparseTransition)
+DECLARE_UDF_EXT(logreg_lbfgs_step_prelim, regress, LogisticRegressionLBFGS::preliminary)
+DECLARE_UDF_EXT(logreg_lbfgs_step_final, regress, LogisticRegressionLBFGS::final)
+DECLARE_UDF_EXT(_logreg_lbfgs_step_distance, regress, LogisticRegressionLBFGS::distance)
+DECLARE_UDF_EXT(_logreg_lbfgs_coef, regress, LogisticRegressionLBFGS::coef)
+DECLARE_UDF_EXT(_logreg_lbfgs_warm_start, regress, LogisticRegressionLBFGS::warmStart)
+
+DECLARE_UDF_EXT(logreg_sgd_step_trans, regress, LogisticRegressionSGD::transition)
+DECLARE_UDF_EXT(logreg_sgd_step_float_trans, regress, LogisticRegressionSGD::floatTransition)
+DECLARE_UDF_EXT(logreg_sgd_step_sparse_trans, regress, LogisticRegressionSGD::sparseTransition)
+DECLARE_UDF_EXT(logreg_sgd_step_prelim, regress, LogisticRegressionSGD::preliminary)
+DECLARE_UDF_EXT(logreg_sgd_step_final, regress, LogisticRegressionSGD::final)
+DECLARE_UDF_EXT(_logreg_sgd_step_distance, regress, LogisticRegressionSGD::distance)
+DECLARE_UDF_EXT(_logreg_sgd_coef, regress, LogisticRegressionSGD::coef)
+
 DECLARE_UDF_EXT(logreg_irls_step_trans, regress, LogisticRegressionIRLS::transition)
+DECLARE_UDF_EXT(logreg_irls_step_float_trans, regress, LogisticRegressionIRLS::floatTransition)
+DECLARE_UDF_EXT(logreg_irls_step_sparse_trans, regress, LogisticRegressionIRLS::sparseTransition)
 DECLARE_UDF_EXT(logreg_irls_step_prelim, regress, LogisticRegressionIRLS::preliminary)
 DECLARE_UDF_EXT(logreg_irls_step_final, regress, LogisticRegressionIRLS::final)
 DECLARE_UDF_EXT(_logreg_irls_step_distance, regress, LogisticRegressionIRLS::distance)
 DECLARE_UDF_EXT(_logreg_irls_coef, regress, LogisticRegressionIRLS::coef)
+
+// regress/multilogistic.hpp
+DECLARE_UDF_EXT(mlogreg_step_trans, regress, MultinomialLogisticRegression::transition)
+DECLARE_UDF_EXT(mlogreg_step_float_trans, regress, MultinomialLogisticRegression::floatTransition)
+DECLARE_UDF_EXT(mlogreg_step_sparse_trans, regress, MultinomialLogisticRegression::sparseTransition)
+DECLARE_UDF_EXT(mlogreg_step_prelim, regress, MultinomialLogisticRegression::preliminary)
+DECLARE_UDF_EXT(mlogreg_step_final, regress, MultinomialLogisticRegression::final)
+DECLARE_UDF_EXT(_mlogreg_step_distance, regress, MultinomialLogisticRegression::distance)
+DECLARE_UDF_EXT(_mlogreg_coef, regress, MultinomialLogisticRegression::coef)
+
+// regress/predict.hpp
+DECLARE_UDF(regress, linreg_predict)
+DECLARE_UDF(regress, linreg_float_predict)
+DECLARE_UDF(regress, linreg_sparse_predict)
+DECLARE_UDF(regress, logreg_predict)
+DECLARE_UDF(regress, logreg_float_predict)
+DECLARE_UDF(regress, logreg_sparse_predict)
@@ -9,8 +9,13 @@
 #ifndef MADLIB_MODULES_MODULES_HPP
 #define MADLIB_MODULES_MODULES_HPP
 
+#include <madlib/modules/prob/chisquared.hpp>
+#include <madlib/modules/prob/fisher.hpp>
+#include <madlib/modules/prob/normal.hpp>
 #include <madlib/modules/prob/student.hpp>
 #include <madlib/modules/regress/linear.hpp>
 #include <madlib/modules/regress/logistic.hpp>
+#include <madlib/modules/regress/multilogistic.hpp>
+#include <madlib/modules/regress/predict.hpp>
 
 #endif
@@ -0,0 +1,96 @@
+/* ----------------------------------------------------------------------- *//**
+ *
+ * @file chisquared.cpp
+ *
+ * @brief Evaluate the chi-squared distribution function and its inverse.
+ *
+ *//* ----------------------------------------------------------------------- */
+
+#include <madlib/modules/prob/chisquared.hpp>
+#include <madlib/modules/prob/distributions.hpp>
+
+#include <boost/math/distributions/chi_squared.hpp>
+
+namespace madlib {
+
+namespace modules {
+
+namespace prob {
+
+typedef boost::math::chi_squared_distribution<double, DistributionPolicy>
+    ChiSquaredDistribution;
+
+static const char *kDegreeOfFreedomError = "Chi-squared distribution "
+    "undefined for degree of freedom <= 0";
+
+/**
+ * Compute Pr[X <= x] for chi-squared distributed X with df degrees of freedom.
+ *
+ * @param df Degree of freedom (> 0). The result is NaN otherwise.
+ * @param x Argument to cdf.
+ */
+double chiSquared_cdf(double df, double x) {
+    return distributionCDF(ChiSquaredDistribution(df), x);
+}
+
+/**
+ * Compute the p-quantile of the chi-squared distribution with df degrees of
+ * freedom. It is infinity for p = 1.
+ */
+double chiSquared_quantile(double df, double p) {
+    return distributionQuantile(ChiSquaredDistribution(df), p);
+}
+
+/**
+ * The arguments are the degree of freedom and the argument to the cdf.
+ */
+AnyValue chi_squared_cdf(AbstractDBInterface &db, AnyValue args) {
+    AnyValue::iterator arg(args);
+
+    // Arguments from SQL call
+    const double df = arg++.getAs<double>();
+    const double x = arg.getAs<double>();
+    
+    checkDegreeOfFreedom(df, kDegreeOfFreedomError);
+    return chiSquared_cdf(df, x);
+}
+
+AnyValue chi_squared_cdf_array(AbstractDBInterface &db, AnyValue args) {
+    AnyValue::iterator arg(args);
+
+    const double df = arg++.getAs<double>();
+    Array_const<double> x = arg.getAs<Array_const<double> >();
+    
+    checkDegreeOfFreedom(df, kDegreeOfFreedomError);
+    return mapArray(db, distributionCDF<ChiSquaredDistribution>,
+        ChiSquaredDistribution(df), x);
+}
+
+AnyValue chi_squared_quantile(AbstractDBInterface &db, AnyValue args) {
+    AnyValue::iterator arg(args);
+
+    const double df = arg++.getAs<double>();
+    const double p = arg.getAs<double>();
+    
+    checkDegreeOfFreedom(df, kDegreeOfFreedomError);
+    checkProbability(p);
+    return chiSquared_quantile(df, p);
+}
+
+AnyValue chi_squared_quantile_array(AbstractDBInterface &db, AnyValue args) {
+    AnyValue::iterator arg(args);
+
+    const double df = arg++.getAs<double>();
+    Array_const<double> p = arg.getAs<Array_const<double> >();
+    
+    checkDegreeOfFreedom(df, kDegreeOfFreedomError);
+    checkProbabilities(p);
+    return mapArray(db, distributionQuantile<ChiSquaredDistribution>,
+        ChiSquaredDistribution(df), p);
+}
+
+} // namespace prob
+
+} // namespace modules
+
+} // namespace madlib
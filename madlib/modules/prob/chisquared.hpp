@@ -0,0 +1,56 @@
+/* ----------------------------------------------------------------------- *//**
+ *
+ * @file chisquared.hpp
+ *
+ * @brief Evaluate the chi-squared distribution function and its inverse.
+ *
+ *//* ----------------------------------------------------------------------- */
+
+#ifndef MADLIB_PROB_CHISQUARED_H
+#define MADLIB_PROB_CHISQUARED_H
+
+#include <madlib/modules/common.hpp>
+
+namespace madlib {
+
+namespace modules {
+
+namespace prob {
+
+/**
+ * C/C++ interface to chi-squared CDF
+ */
+double chiSquared_cdf(double df, double x);
+
+/**
+ * C/C++ interface to chi-squared quantile function
+ */
+double chiSquared_quantile(double df, double p);
+
+/**
+ * In-DB interface to chi-squared CDF
+ */
+AnyValue chi_squared_cdf(AbstractDBInterface &db, AnyValue args);
+
+/**
+ * In-DB interface to chi-squared CDF for an array of values
+ */
+AnyValue chi_squared_cdf_array(AbstractDBInterface &db, AnyValue args);
+
+/**
+ * In-DB interface to chi-squared quantile function
+ */
+AnyValue chi_squared_quantile(AbstractDBInterface &db, AnyValue args);
+
+/**
+ * In-DB interface to chi-squared quantile function for an array of probabilities
+ */
+AnyValue chi_squared_quantile_array(AbstractDBInterface &db, AnyValue args);
+
+} // namespace prob
+
+} // namespace modules
+
+} // namespace madlib
+
+#endif
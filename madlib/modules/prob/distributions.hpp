@@ -0,0 +1,120 @@
+/* ----------------------------------------------------------------------- *//**
+ *
+ * @file distributions.hpp
+ *
+ * @brief Helpers shared by the distribution functions of the prob module
+ *
+ * The distributions other than Student-t are taken from Boost.Math. This file
+ * contains the error-handling policy we instantiate them with and the code
+ * that the scalar and the array UDFs have in common.
+ *
+ *//* ----------------------------------------------------------------------- */
+
+#ifndef MADLIB_PROB_DISTRIBUTIONS_H
+#define MADLIB_PROB_DISTRIBUTIONS_H
+
+#include <madlib/modules/common.hpp>
+
+#include <boost/math/policies/policy.hpp>
+
+#include <stdexcept>
+#include <utility>
+
+namespace madlib {
+
+namespace modules {
+
+namespace prob {
+
+/**
+ * @brief Error-handling policy for Boost.Math distributions
+ *
+ * The UDFs check their arguments themselves and throw std::domain_error with
+ * messages that refer to the SQL arguments. Within Boost, invalid arguments
+ * (such as NaN) therefore yield NaN, and quantiles of 0 or 1 for unbounded
+ * support yield an infinite value.
+ */
+typedef boost::math::policies::policy<
+    boost::math::policies::domain_error<boost::math::policies::ignore_error>,
+    boost::math::policies::overflow_error<boost::math::policies::ignore_error>
+> DistributionPolicy;
+
+/**
+ * @brief Distribution function, defined for all real numbers
+ *
+ * Boost.Math only accepts arguments within the support of a distribution.
+ * Outside, the distribution function is 0 or 1.
+ */
+template <class Distribution>
+inline double distributionCDF(const Distribution &inDist, double inX) {
+    const std::pair<double, double> range = support(inDist);
+
+    if (inX < range.first)
+        return 0.;
+    else if (inX > range.second)
+        return 1.;
+    return cdf(inDist, inX);
+}
+
+/**
+ * @brief Quantile function, NaN if the probability is not in [0, 1]
+ */
+template <class Distribution>
+inline double distributionQuantile(const Distribution &inDist, double inP) {
+    return quantile(inDist, inP);
+}
+
+/**
+ * @brief Throw if a degree of freedom is not positive
+ */
+inline void checkDegreeOfFreedom(double inDF, const char *inMessage) {
+    if (!(inDF > 0))
+        throw std::domain_error(inMessage);
+}
+
+/**
+ * @brief Throw if a value is not a probability
+ */
+inline void checkProbability(double inP) {
+    if (!(inP >= 0 && inP <= 1))
+        throw std::domain_error("Probability must be between 0 and 1");
+}
+
+/**
+ * @brief Throw if an element of an array is not a probability
+ */
+inline void checkProbabilities(const Array_const<double> &inP) {
+    const double *p = inP.data();
+    for (size_t i = 0; i < inP.size(); i++)
+        checkProbability(p[i]);
+}
+
+/**
+ * @brief Apply a function to every element of an array
+ *
+ * This is the implementation of all array UDFs: A single call evaluates all
+ * values, and the distribution (including everything it precomputes) is
+ * constructed only once.
+ *
+ * @param inFunction Function that is called as <tt>inFunction(inDist, x)</tt>
+ *     for every element \c x of \c inX
+ */
+template <class Distribution>
+inline DoubleCol mapArray(AbstractDBInterface &db,
+    double (*inFunction)(const Distribution &, double),
+    const Distribution &inDist, const Array_const<double> &inX) {
+    
+    DoubleCol result(db.allocator(), inX.size());
+    const double *x = inX.data();
+    for (size_t i = 0; i < inX.size(); i++)
+        result(i) = inFunction(inDist, x[i]);
+    return result;
+}
+
+} // namespace prob
+
+} // namespace modules
+
+} // namespace madlib
+
+#endif
@@ -0,0 +1,107 @@
+/* ----------------------------------------------------------------------- *//**
+ *
+ * @file fisher.cpp
+ *
+ * @brief Evaluate the Fisher F distribution function and its inverse.
+ *
+ *//* ----------------------------------------------------------------------- */
+
+#include <madlib/modules/prob/fisher.hpp>
+#include <madlib/modules/prob/distributions.hpp>
+
+#include <boost/math/distributions/fisher_f.hpp>
+
+namespace madlib {
+
+namespace modules {
+
+namespace prob {
+
+typedef boost::math::fisher_f_distribution<double, DistributionPolicy>
+    FisherFDistribution;
+
+static const char *kDegreeOfFreedomError = "Fisher F distribution undefined "
+    "for degrees of freedom <= 0";
+
+/**
+ * Compute Pr[X <= x] for F-distributed X with df1 and df2 degrees of freedom.
+ *
+ * @param df1 Degree of freedom of the numerator (> 0)
+ * @param df2 Degree of freedom of the denominator (> 0)
+ * @param x Argument to cdf.
+ *
+ * The result is NaN if a degree of freedom is not positive.
+ */
+double fisherF_cdf(double df1, double df2, double x) {
+    return distributionCDF(FisherFDistribution(df1, df2), x);
+}
+
+/**
+ * Compute the p-quantile of the F distribution with df1 and df2 degrees of
+ * freedom. It is infinity for p = 1.
+ */
+double fisherF_quantile(double df1, double df2, double p) {
+    return distributionQuantile(FisherFDistribution(df1, df2), p);
+}
+
+/**
+ * The arguments are the two degrees of freedom and the argument to the cdf.
+ */
+AnyValue fisher_f_cdf(AbstractDBInterface &db, AnyValue args) {
+    AnyValue::iterator arg(args);
+
+    // Arguments from SQL call
+    const double df1 = arg++.getAs<double>();
+    const double df2 = arg++.getAs<double>();
+    const double x = arg.getAs<double>();
+    
+    checkDegreeOfFreedom(df1, kDegreeOfFreedomError);
+    checkDegreeOfFreedom(df2, kDegreeOfFreedomError);
+    return fisherF_cdf(df1, df2, x);
+}
+
+AnyValue fisher_f_cdf_array(AbstractDBInterface &db, AnyValue args) {
+    AnyValue::iterator arg(args);
+
+    const double df1 = arg++.getAs<double>();
+    const double df2 = arg++.getAs<double>();
+    Array_const<double> x = arg.getAs<Array_const<double> >();
+    
+    checkDegreeOfFreedom(df1, kDegreeOfFreedomError);
+    checkDegreeOfFreedom(df2, kDegreeOfFreedomError);
+    return mapArray(db, distributionCDF<FisherFDistribution>,
+        FisherFDistribution(df1, df2), x);
+}
+
+AnyValue fisher_f_quantile(AbstractDBInterface &db, AnyValue args) {
+    AnyValue::iterator arg(args);
+
+    const double df1 = arg++.getAs<double>();
+    const double df2 = arg++.getAs<double>();
+    const double p = arg.getAs<double>();
+    
+    checkDegreeOfFreedom(df1, kDegreeOfFreedomError);
+    checkDegreeOfFreedom(df2, kDegreeOfFreedomError);
+    checkProbability(p);
+    return fisherF_quantile(df1, df2, p);
+}
+
+AnyValue fisher_f_quantile_array(AbstractDBInterface &db, AnyValue args) {
+    AnyValue::iterator arg(args);
+
+    const double df1 = arg++.getAs<double>();
+    const double df2 = arg++.getAs<double>();
+    Array_const<double> p = arg.getAs<Array_const<double> >();
+    
+    checkDegreeOfFreedom(df1, kDegreeOfFreedomError);
+    checkDegreeOfFreedom(df2, kDegreeOfFreedomError);
+    checkProbabilities(p);
+    return mapArray(db, distributionQuantile<FisherFDistribution>,
+        FisherFDistribution(df1, df2), p);
+}
+
+} // namespace prob
+
+} // namespace modules
+
+} // namespace madlib
@@ -0,0 +1,56 @@
+/* ----------------------------------------------------------------------- *//**
+ *
+ * @file fisher.hpp
+ *
+ * @brief Evaluate the Fisher F distribution function and its inverse.
+ *
+ *//* ----------------------------------------------------------------------- */
+
+#ifndef MADLIB_PROB_FISHER_H
+#define MADLIB_PROB_FISHER_H
+
+#include <madlib/modules/common.hpp>
+
+namespace madlib {
+
+namespace modules {
+
+namespace prob {
+
+/**
+ * C/C++ interface to Fisher F CDF
+ */
+double fisherF_cdf(double df1, double df2, double x);
+
+/**
+ * C/C++ interface to Fisher F quantile function
+ */
+double fisherF_quantile(double df1, double df2, double p);
+
+/**
+ * In-DB interface to Fisher F CDF
+ */
+AnyValue fisher_f_cdf(AbstractDBInterface &db, AnyValue args);
+
+/**
+ * In-DB interface to Fisher F CDF for an array of values
+ */
+AnyValue fisher_f_cdf_array(AbstractDBInterface &db, AnyValue args);
+
+/**
+ * In-DB interface to Fisher F quantile function
+ */
+AnyValue fisher_f_quantile(AbstractDBInterface &db, AnyValue args);
+
+/**
+ * In-DB interface to Fisher F quantile function for an array of probabilities
+ */
+AnyValue fisher_f_quantile_array(AbstractDBInterface &db, AnyValue args);
+
+} // namespace prob
+
+} // namespace modules
+
+} // namespace madlib
+
+#endif
@@ -0,0 +1,75 @@
+/* ----------------------------------------------------------------------- *//**
+ *
+ * @file normal.cpp
+ *
+ * @brief Evaluate the standard normal distribution function and its inverse.
+ *
+ *//* ----------------------------------------------------------------------- */
+
+#include <madlib/modules/prob/normal.hpp>
+#include <madlib/modules/prob/distributions.hpp>
+
+#include <boost/math/distributions/normal.hpp>
+
+namespace madlib {
+
+namespace modules {
+
+namespace prob {
+
+typedef boost::math::normal_distribution<double, DistributionPolicy>
+    NormalDistribution;
+
+/**
+ * Compute Pr[X <= x] for a standard normal random variable X.
+ *
+ * Boost.Math uses the complementary error function, so that the lower tail is
+ * accurate also far away from 0.
+ */
+double standardNormal_cdf(double x) {
+    return distributionCDF(NormalDistribution(), x);
+}
+
+/**
+ * Compute the p-quantile of the standard normal distribution. It is -infinity
+ * for p = 0 and infinity for p = 1.
+ */
+double standardNormal_quantile(double p) {
+    return distributionQuantile(NormalDistribution(), p);
+}
+
+AnyValue normal_cdf(AbstractDBInterface &db, AnyValue args) {
+    AnyValue::iterator arg(args);
+
+    return standardNormal_cdf(arg.getAs<double>());
+}
+
+AnyValue normal_cdf_array(AbstractDBInterface &db, AnyValue args) {
+    AnyValue::iterator arg(args);
+
+    return mapArray(db, distributionCDF<NormalDistribution>,
+        NormalDistribution(), arg.getAs<Array_const<double> >());
+}
+
+AnyValue normal_quantile(AbstractDBInterface &db, AnyValue args) {
+    AnyValue::iterator arg(args);
+    const double p = arg.getAs<double>();
+    
+    checkProbability(p);
+    return standardNormal_quantile(p);
+}
+
+AnyValue normal_quantile_array(AbstractDBInterface &db, AnyValue args) {
+    AnyValue::iterator arg(args);
+    Array_const<double> p = arg.getAs<Array_const<double> >();
+    
+    checkProbabilities(p);
+    return mapArray(db, distributionQuantile<NormalDistribution>,
+        NormalDistribution(), p);
+}
+
+} // namespace prob
+
+} // namespace modules
+
+} // namespace madlib
@@ -0,0 +1,56 @@
+/* ----------------------------------------------------------------------- *//**
+ *
+ * @file normal.hpp
+ *
+ * @brief Evaluate the standard normal distribution function and its inverse.
+ *
+ *//* ----------------------------------------------------------------------- */
+
+#ifndef MADLIB_PROB_NORMAL_H
+#define MADLIB_PROB_NORMAL_H
+
+#include <madlib/modules/common.hpp>
+
+namespace madlib {
+
+namespace modules {
+
+namespace prob {
+
+/**
+ * C/C++ interface to standard normal CDF
+ */
+double standardNormal_cdf(double x);
+
+/**
+ * C/C++ interface to standard normal quantile function
+ */
+double standardNormal_quantile(double p);
+
+/**
+ * In-DB interface to standard normal CDF
+ */
+AnyValue normal_cdf(AbstractDBInterface &db, AnyValue args);
+
+/**
+ * In-DB interface to standard normal CDF for an array of values
+ */
+AnyValue normal_cdf_array(AbstractDBInterface &db, AnyValue args);
+
+/**
+ * In-DB interface to standard normal quantile function
+ */
+AnyValue normal_quantile(AbstractDBInterface &db, AnyValue args);
+
+/**
+ * In-DB interface to standard normal quantile function for an array of probabilities
+ */
+AnyValue normal_quantile_array(AbstractDBInterface &db, AnyValue args);
+
+} // namespace prob
+
+} // namespace modules
+
+} // namespace madlib
+
+#endif
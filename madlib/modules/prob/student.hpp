@@ -22,11 +22,38 @@ namespace prob {
  */
 double studentT_cdf(int64_t nu, double t);
 
+/**
+ * C/C++ interface to Student-t CDF for many values with the same degree of
+ * freedom
+ */
+void studentT_cdf(int64_t nu, const double *inT, double *outCDF, size_t inN);
+
+/**
+ * C/C++ interface to Student-t quantile function
+ */
+double studentT_quantile(int64_t nu, double p);
+
 /**
  * In-DB interface to Student-t CDF
  */
 AnyValue student_t_cdf(AbstractDBInterface &db, AnyValue args);
 
+/**
+ * In-DB interface to Student-t CDF for an array of values
+ */
+AnyValue student_t_cdf_array(AbstractDBInterface &db, AnyValue args);
+
+/**
+ * In-DB interface to Student-t quantile function
+ */
+AnyValue student_t_quantile(AbstractDBInterface &db, AnyValue args);
+
+/**
+ * In-DB interface to Student-t quantile function for an array of
+ * probabilities
+ */
+AnyValue student_t_quantile_array(AbstractDBInterface &db, AnyValue args);
+
 } // namespace prob
 
 } // namespace modules
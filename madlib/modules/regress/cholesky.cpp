@@ -0,0 +1,230 @@
+/* ----------------------------------------------------------------------- *//**
+ *
+ * @file cholesky.cpp
+ *
+ * @brief Blocked and multi-threaded Cholesky decomposition
+ *
+ *//* ----------------------------------------------------------------------- */
+
+#include <madlib/modules/regress/cholesky.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace madlib {
+
+namespace modules {
+
+namespace regress {
+
+namespace {
+
+/**
+ * Number of columns that are factorized in one block. Worker threads are
+ * synchronized twice per block.
+ */
+const arma::u32 kBlockSize = 64;
+
+/**
+ * @brief Dot product of two contiguous vectors
+ *
+ * We use four partial sums so that the compiler can keep several
+ * multiply-add operations in flight.
+ */
+inline double dot(const double *inX, const double *inY, arma::u32 inN) {
+    double sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0;
+    arma::u32 i = 0;
+    for (; i + 4 <= inN; i += 4) {
+        sum0 += inX[i] * inY[i];
+        sum1 += inX[i + 1] * inY[i + 1];
+        sum2 += inX[i + 2] * inY[i + 2];
+        sum3 += inX[i + 3] * inY[i + 3];
+    }
+    for (; i < inN; i++)
+        sum0 += inX[i] * inY[i];
+    return (sum0 + sum1) + (sum2 + sum3);
+}
+
+} // namespace
+
+/**
+ * @brief The rows <tt>[begin, end)</tt> of R right of the diagonal block
+ */
+struct CholeskyDecomposition::Panel {
+    double *r;
+    arma::u32 n;
+    arma::u32 begin;
+    arma::u32 end;
+};
+
+struct CholeskyDecomposition::InverseDiagonal {
+    const double *r;
+    arma::u32 n;
+    double *scratch;
+    double *diagonal;
+};
+
+/**
+ * @brief Factorize a symmetric positive definite matrix
+ *
+ * We use the right-looking blocked algorithm: After factorizing a diagonal
+ * block on the calling thread, the rows of R right of it (the panel) and
+ * then the trailing matrix are computed column by column. Columns are
+ * assigned to the threads in a round-robin fashion, which balances the
+ * triangular workload of the trailing update.
+ *
+ * @param inA Symmetric matrix. Only the upper triangle is read.
+ * @param inNumThreads Number of threads to use, including the calling one
+ */
+CholeskyDecomposition::CholeskyDecomposition(const arma::Mat<double> &inA,
+    unsigned int inNumThreads)
+    : mR(inA), mOriginalDiagonal(inA.n_rows), mThreadPool(inNumThreads),
+      mIsPositiveDefinite(false) {
+
+    if (mR.n_rows != mR.n_cols)
+        throw std::invalid_argument("Cholesky decomposition requires a square "
+            "matrix");
+
+    const arma::u32 n = mR.n_rows;
+    for (arma::u32 i = 0; i < n; i++)
+        mOriginalDiagonal(i) = mR.at(i, i);
+
+    for (arma::u32 begin = 0; begin < n; begin += kBlockSize) {
+        arma::u32 end = std::min(begin + kBlockSize, n);
+        if (!factorizeDiagonalBlock(begin, end))
+            return;
+
+        if (end < n) {
+            Panel panel = { mR.memptr(), n, begin, end };
+            mThreadPool.run(solvePanel, &panel);
+            mThreadPool.run(updateTrailingMatrix, &panel);
+        }
+    }
+    mIsPositiveDefinite = true;
+}
+
+/**
+ * @brief Unblocked factorization of a diagonal block
+ *
+ * A pivot that is not larger than \f$ n \epsilon \f$ times the corresponding
+ * diagonal element of the original matrix means that the column is (almost)
+ * a linear combination of the previous ones. We then treat the matrix as
+ * rank-deficient.
+ *
+ * @return Whether all pivots were positive
+ */
+bool CholeskyDecomposition::factorizeDiagonalBlock(arma::u32 inBegin,
+    arma::u32 inEnd) {
+
+    const double tolerance = mR.n_rows * std::numeric_limits<double>::epsilon();
+
+    for (arma::u32 j = inBegin; j < inEnd; j++) {
+        double *colJ = mR.colptr(j);
+        for (arma::u32 i = inBegin; i < j; i++) {
+            const double *colI = mR.colptr(i);
+            colJ[i] = (colJ[i] - dot(colI + inBegin, colJ + inBegin, i - inBegin))
+                / colI[i];
+        }
+
+        double pivot = colJ[j] - dot(colJ + inBegin, colJ + inBegin, j - inBegin);
+        // Also catches NaN
+        if (!(pivot > tolerance * mOriginalDiagonal(j)))
+            return false;
+        colJ[j] = std::sqrt(pivot);
+    }
+    return true;
+}
+
+void CholeskyDecomposition::solvePanel(void *inContext, unsigned int inPart,
+    unsigned int inNumParts) {
+
+    const Panel &panel = *static_cast<Panel*>(inContext);
+
+    for (arma::u32 j = panel.end + inPart; j < panel.n; j += inNumParts) {
+        double *colJ = panel.r + j * panel.n;
+        for (arma::u32 i = panel.begin; i < panel.end; i++) {
+            const double *colI = panel.r + i * panel.n;
+            colJ[i] = (colJ[i] - dot(colI + panel.begin, colJ + panel.begin,
+                i - panel.begin)) / colI[i];
+        }
+    }
+}
+
+void CholeskyDecomposition::updateTrailingMatrix(void *inContext,
+    unsigned int inPart, unsigned int inNumParts) {
+
+    const Panel &panel = *static_cast<Panel*>(inContext);
+    const arma::u32 blockSize = panel.end - panel.begin;
+
+    for (arma::u32 j = panel.end + inPart; j < panel.n; j += inNumParts) {
+        double *colJ = panel.r + j * panel.n;
+        for (arma::u32 i = panel.end; i <= j; i++) {
+            const double *colI = panel.r + i * panel.n;
+            colJ[i] -= dot(colI + panel.begin, colJ + panel.begin, blockSize);
+        }
+    }
+}
+
+/**
+ * @brief Solve \f$ A x = b \f$
+ *
+ * This first solves \f$ R^T z = b \f$ and then \f$ R x = z \f$. \c inB and
+ * \c outX may point to the same memory.
+ */
+void CholeskyDecomposition::solve(const double *inB, double *outX) const {
+    const arma::u32 n = mR.n_rows;
+
+    for (arma::u32 j = 0; j < n; j++) {
+        const double *colJ = mR.colptr(j);
+        outX[j] = (inB[j] - dot(colJ, outX, j)) / colJ[j];
+    }
+
+    for (arma::u32 j = n; j-- > 0; ) {
+        const double *colJ = mR.colptr(j);
+        outX[j] /= colJ[j];
+        for (arma::u32 i = 0; i < j; i++)
+            outX[i] -= colJ[i] * outX[j];
+    }
+}
+
+/**
+ * @brief Compute the diagonal of \f$ A^{-1} \f$
+ *
+ * Since \f$ A^{-1} = R^{-1} R^{-T} \f$, the i-th diagonal element is
+ * \f$ \| R^{-T} e_i \|^2 \f$. The first i elements of \f$ R^{-T} e_i \f$ are
+ * zero, so each diagonal element is an independent forward substitution of
+ * length \f$ n - i \f$.
+ */
+void CholeskyDecomposition::inverseDiagonal(double *outDiagonal) {
+    const arma::u32 n = mR.n_rows;
+
+    // Scratch space for the worker threads has to be allocated here
+    arma::Mat<double> scratch(n, mThreadPool.size());
+    InverseDiagonal context = { mR.memptr(), n, scratch.memptr(), outDiagonal };
+    mThreadPool.run(computeInverseDiagonal, &context);
+}
+
+void CholeskyDecomposition::computeInverseDiagonal(void *inContext,
+    unsigned int inPart, unsigned int inNumParts) {
+
+    const InverseDiagonal &context = *static_cast<InverseDiagonal*>(inContext);
+    const arma::u32 n = context.n;
+    double *y = context.scratch + inPart * n;
+
+    for (arma::u32 i = inPart; i < n; i += inNumParts) {
+        // y = R^{-T} e_i, without the leading zeros
+        y[0] = 1. / context.r[i + i * n];
+        for (arma::u32 q = i + 1; q < n; q++) {
+            const double *colQ = context.r + q * n;
+            y[q - i] = -dot(colQ + i, y, q - i) / colQ[q];
+        }
+        context.diagonal[i] = dot(y, y, n - i);
+    }
+}
+
+} // namespace regress
+
+} // namespace modules
+
+} // namespace madlib
@@ -0,0 +1,79 @@
+/* ----------------------------------------------------------------------- *//**
+ *
+ * @file cholesky.hpp
+ *
+ * @brief Cholesky decomposition of symmetric positive definite matrices
+ *
+ *//* ----------------------------------------------------------------------- */
+
+#ifndef MADLIB_REGRESS_CHOLESKY_H
+#define MADLIB_REGRESS_CHOLESKY_H
+
+#include <madlib/modules/common.hpp>
+#include <madlib/utils/ThreadPool.hpp>
+
+namespace madlib {
+
+namespace modules {
+
+namespace regress {
+
+/**
+ * @brief Cholesky decomposition \f$ A = R^T R \f$ with upper triangular
+ *        \f$ R \f$
+ *
+ * Only the upper triangle of the matrix passed to the constructor is read, so
+ * the lower triangle need not be filled in. The factorization is blocked and
+ * spread over a utils::ThreadPool. Neither the factorization nor any of the
+ * other member functions allocate memory in worker threads.
+ *
+ * If the matrix is not (numerically) positive definite, isPositiveDefinite()
+ * returns false and no other member function may be called. Callers should
+ * then fall back to the pseudo-inverse.
+ */
+class CholeskyDecomposition {
+public:
+    CholeskyDecomposition(const arma::Mat<double> &inA,
+        unsigned int inNumThreads = 1);
+
+    bool isPositiveDefinite() const {
+        return mIsPositiveDefinite;
+    }
+
+    void solve(const double *inB, double *outX) const;
+    void inverseDiagonal(double *outDiagonal);
+
+private:
+    struct Panel;
+    struct InverseDiagonal;
+
+    bool factorizeDiagonalBlock(arma::u32 inBegin, arma::u32 inEnd);
+
+    static void solvePanel(void *inContext, unsigned int inPart,
+        unsigned int inNumParts);
+    static void updateTrailingMatrix(void *inContext, unsigned int inPart,
+        unsigned int inNumParts);
+    static void computeInverseDiagonal(void *inContext, unsigned int inPart,
+        unsigned int inNumParts);
+
+    /**
+     * Upper triangle of R. The strictly lower triangle is not used.
+     */
+    arma::Mat<double> mR;
+
+    /**
+     * Diagonal of the original matrix, used for detecting rank deficiency
+     */
+    arma::Col<double> mOriginalDiagonal;
+
+    utils::ThreadPool mThreadPool;
+    bool mIsPositiveDefinite;
+};
+
+} // namespace regress
+
+} // namespace modules
+
+} // namespace madlib
+
+#endif
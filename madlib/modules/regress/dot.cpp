@@ -0,0 +1,79 @@
+/* ----------------------------------------------------------------------- *//**
+ *
+ * @file dot.cpp
+ *
+ * @brief Vectorized dot products
+ *
+ *//* ----------------------------------------------------------------------- */
+
+#include <madlib/modules/regress/dot.hpp>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace madlib {
+
+namespace modules {
+
+namespace regress {
+
+double dot(const double *inX, const double *inC, uint64_t inN) {
+    uint64_t i = 0;
+    double result = 0;
+
+#if defined(__SSE2__)
+    __m128d sums0 = _mm_setzero_pd();
+    __m128d sums1 = _mm_setzero_pd();
+
+    for (; i + 4 <= inN; i += 4) {
+        sums0 = _mm_add_pd(sums0,
+            _mm_mul_pd(_mm_loadu_pd(inX + i), _mm_loadu_pd(inC + i)));
+        sums1 = _mm_add_pd(sums1,
+            _mm_mul_pd(_mm_loadu_pd(inX + i + 2), _mm_loadu_pd(inC + i + 2)));
+    }
+
+    double partialSums[2];
+    _mm_storeu_pd(partialSums, _mm_add_pd(sums0, sums1));
+    result = partialSums[0] + partialSums[1];
+#endif
+
+    for (; i < inN; i++)
+        result += inX[i] * inC[i];
+    return result;
+}
+
+double dot(const float *inX, const double *inC, uint64_t inN) {
+    uint64_t i = 0;
+    double result = 0;
+
+#if defined(__SSE2__)
+    __m128d sums0 = _mm_setzero_pd();
+    __m128d sums1 = _mm_setzero_pd();
+
+    for (; i + 4 <= inN; i += 4) {
+        // Load four floats and widen the lower and upper pair to doubles
+        __m128 x = _mm_loadu_ps(inX + i);
+        __m128d xLow = _mm_cvtps_pd(x);
+        __m128d xHigh = _mm_cvtps_pd(_mm_movehl_ps(x, x));
+
+        sums0 = _mm_add_pd(sums0, _mm_mul_pd(xLow, _mm_loadu_pd(inC + i)));
+        sums1 = _mm_add_pd(sums1,
+            _mm_mul_pd(xHigh, _mm_loadu_pd(inC + i + 2)));
+    }
+
+    double partialSums[2];
+    _mm_storeu_pd(partialSums, _mm_add_pd(sums0, sums1));
+    result = partialSums[0] + partialSums[1];
+#endif
+
+    for (; i < inN; i++)
+        result += static_cast<double>(inX[i]) * inC[i];
+    return result;
+}
+
+} // namespace regress
+
+} // namespace modules
+
+} // namespace madlib
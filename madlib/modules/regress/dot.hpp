@@ -0,0 +1,47 @@
+/* ----------------------------------------------------------------------- *//**
+ *
+ * @file dot.hpp
+ *
+ * @brief Dot products of dense rows with a coefficient vector
+ *
+ *//* ----------------------------------------------------------------------- */
+
+#ifndef MADLIB_REGRESS_DOT_H
+#define MADLIB_REGRESS_DOT_H
+
+#include <madlib/modules/common.hpp>
+
+namespace madlib {
+
+namespace modules {
+
+namespace regress {
+
+/**
+ * @brief Dot product \f$ \sum_{i=0}^{n-1} x_i c_i \f$
+ *
+ * On x86 processors with SSE2, four products are accumulated at a time in
+ * two independent registers. The summation order therefore differs from a
+ * plain loop, and results may differ in the last few places.
+ *
+ * @param inX First vector. There are no alignment requirements.
+ * @param inC Second vector. There are no alignment requirements.
+ * @param inN Length of both vectors
+ */
+double dot(const double *inX, const double *inC, uint64_t inN);
+
+/**
+ * @brief Dot product of a single-precision with a double-precision vector
+ *
+ * Elements of \c inX are converted to double precision before they are
+ * multiplied, and all sums are accumulated in double precision.
+ */
+double dot(const float *inX, const double *inC, uint64_t inN);
+
+} // namespace regress
+
+} // namespace modules
+
+} // namespace madlib
+
+#endif
@@ -0,0 +1,252 @@
+/* ----------------------------------------------------------------------- *//**
+ *
+ * @file linalg.hpp
+ *
+ * @brief Small linear-algebra kernels used by the regression transition
+ *        functions
+ *
+ *//* ----------------------------------------------------------------------- */
+
+#ifndef MADLIB_REGRESS_LINALG_H
+#define MADLIB_REGRESS_LINALG_H
+
+#include <madlib/modules/common.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace madlib {
+
+namespace modules {
+
+namespace regress {
+
+/**
+ * @brief Number of elements of a symmetric n x n matrix in packed storage
+ *
+ * Symmetric matrices in transition states are kept in packed storage, as
+ * BLAS calls it: The upper triangle (including the diagonal) is stored column
+ * by column, so element (i, j) with \f$ i \leq j \f$ is at position
+ * \f$ i + j (j + 1) / 2 \f$. This halves the size of the states, and hence
+ * also what has to be merged and sent between segments. unpackSymmetric()
+ * expands a packed matrix for the final step.
+ */
+inline uint64_t packedSize(const uint64_t inN) {
+    return inN * (inN + 1) / 2;
+}
+
+/**
+ * @brief Pointer to column j of a matrix in packed storage
+ */
+inline double *packedColumn(double *inAP, const uint32_t inJ) {
+    return inAP + packedSize(inJ);
+}
+
+/**
+ * @brief Symmetric rank-1 update in packed storage: \f$ A += \alpha x x^T \f$
+ *
+ * This is what BLAS calls dspr, and no temporary outer product is formed.
+ *
+ * @param ioAP Matrix \f$ A \f$ in packed storage
+ * @param inN Number of rows and columns of \f$ A \f$, which is also the
+ *     length of \c inX
+ * @param inX Pointer to the first element of \f$ x \f$. The elements may also
+ *     be single precision, they are converted when they are used.
+ * @param inAlpha Scale factor \f$ \alpha \f$
+ */
+template <typename T>
+inline void packedRankOneUpdate(double *ioAP, const uint32_t inN,
+    const T *inX, const double inAlpha = 1.) {
+    
+    double *colJ = ioAP;
+    for (uint32_t j = 0; j < inN; colJ += ++j) {
+        const double alphaXj = inAlpha * inX[j];
+        if (alphaXj == 0)
+            continue;
+        
+        for (uint32_t i = 0; i <= j; i++)
+            colJ[i] += inX[i] * alphaXj;
+    }
+}
+
+/**
+ * @brief Symmetric rank-1 update in packed storage with a sparse vector
+ *
+ * Like packedRankOneUpdate() for a dense vector, but only the
+ * \f$ \mathit{nnz} (\mathit{nnz} + 1) / 2 \f$ elements that change are
+ * written. Since the indices of \c inX are increasing, row \c index(a) is not
+ * greater than column \c index(b) for all \f$ a \leq b \f$.
+ *
+ * The size parameter is unused. It only makes the signature the same as for
+ * dense vectors, so that callers can pass the result of rowElements().
+ */
+inline void packedRankOneUpdate(double *ioAP, const uint32_t /* inN */,
+    const SparseVector_const &inX, const double inAlpha = 1.) {
+    
+    for (uint32_t b = 0; b < inX.n_nonzero; b++) {
+        const double alphaXj = inAlpha * inX.value(b);
+        if (alphaXj == 0)
+            continue;
+        
+        double *colJ = packedColumn(ioAP, inX.index(b));
+        for (uint32_t a = 0; a <= b; a++)
+            colJ[inX.index(a)] += inX.value(a) * alphaXj;
+    }
+}
+
+/**
+ * @brief Symmetric rank-k update in packed storage: \f$ C += A A^T \f$
+ *
+ * BLAS has no rank-k update for packed storage. We therefore compute \f$ C \f$
+ * in panels of kPanelWidth columns: Each panel of the upper triangle is a
+ * single matrix product (a BLAS level-3 call), which is then added to the
+ * packed matrix. The extra work for the part of a panel below the diagonal is
+ * small, and the only temporary memory is the transpose of \f$ A \f$ and one
+ * panel.
+ *
+ * @param ioCP Matrix \f$ C \f$ in packed storage
+ * @param inN Number of rows and columns of \f$ C \f$
+ * @param inA Matrix with \c inN rows and \c inK columns, stored
+ *     contiguously in column-major order
+ * @param inK Number of columns of \f$ A \f$
+ */
+inline void packedRankKUpdate(double *ioCP, const uint32_t inN,
+    const double *inA, const uint32_t inK) {
+    
+    const uint32_t kPanelWidth = 64;
+    
+    if (inK == 0 || inN == 0)
+        return;
+    
+    // Column i of A_transp contains row i of A, so that the rows of every
+    // panel are contiguous
+    arma::Mat<double> A_transp(inK, inN);
+    for (uint32_t l = 0; l < inK; l++)
+        for (uint32_t i = 0; i < inN; i++)
+            A_transp.at(l, i) = inA[l * inN + i];
+    
+    for (uint32_t begin = 0; begin < inN; begin += kPanelWidth) {
+        const uint32_t end = std::min(inN, begin + kPanelWidth);
+        const arma::Mat<double> upper(A_transp.memptr(), inK, end,
+            false /* copy_aux_mem */, true /* strict */);
+        const arma::Mat<double> panelA(A_transp.colptr(begin), inK,
+            end - begin, false /* copy_aux_mem */, true /* strict */);
+        const arma::Mat<double> panel = arma::trans(upper) * panelA;
+        
+        for (uint32_t j = begin; j < end; j++) {
+            double *colJ = packedColumn(ioCP, j);
+            const double *panelJ = panel.colptr(j - begin);
+            for (uint32_t i = 0; i <= j; i++)
+                colJ[i] += panelJ[i];
+        }
+    }
+}
+
+/**
+ * @brief Compensated summation: Add a value to a sum and its running error
+ *
+ * This is the Kahan-Babuska summation as improved by Neumaier: The low-order
+ * bits lost in <tt>ioSum + inValue</tt> are collected in \c ioCompensation,
+ * also if \c inValue is larger in magnitude than \c ioSum. The compensated
+ * sum is <tt>ioSum + ioCompensation</tt>.
+ *
+ * Two compensated sums \f$ (s_1, c_1) \f$ and \f$ (s_2, c_2) \f$ are merged
+ * by adding \f$ s_2 \f$ to \f$ (s_1, c_1) \f$ with this function and then
+ * adding \f$ c_2 \f$ to \f$ c_1 \f$.
+ *
+ * @internal This is a template so that \c ioSum and \c ioCompensation can
+ *     also be utils::Reference objects.
+ */
+template <class Sum, class Compensation>
+inline void compensatedAdd(Sum &ioSum, Compensation &ioCompensation,
+    const double inValue) {
+    
+    const double sum = ioSum;
+    const double newSum = sum + inValue;
+    if (std::fabs(sum) >= std::fabs(inValue))
+        ioCompensation += (sum - newSum) + inValue;
+    else
+        ioCompensation += (inValue - newSum) + sum;
+    ioSum = newSum;
+}
+
+/**
+ * @brief Compensated symmetric rank-1 update in packed storage
+ *
+ * Like packedRankOneUpdate(), but each element is added with
+ * compensatedAdd(), and the error terms are collected in \c ioCompensation,
+ * which is in packed storage, too.
+ */
+template <typename T>
+inline void compensatedRankOneUpdate(double *ioAP, double *ioCompensation,
+    const uint32_t inN, const T *inX) {
+    
+    double *colJ = ioAP;
+    double *compensationJ = ioCompensation;
+    for (uint32_t j = 0; j < inN; colJ += ++j, compensationJ += j) {
+        const double xj = inX[j];
+        if (xj == 0)
+            continue;
+        
+        for (uint32_t i = 0; i <= j; i++)
+            compensatedAdd(colJ[i], compensationJ[i], inX[i] * xj);
+    }
+}
+
+/**
+ * @brief Compensated symmetric rank-1 update in packed storage with a sparse
+ *     vector
+ */
+inline void compensatedRankOneUpdate(double *ioAP, double *ioCompensation,
+    const uint32_t /* inN */, const SparseVector_const &inX) {
+    
+    for (uint32_t b = 0; b < inX.n_nonzero; b++) {
+        const double xj = inX.value(b);
+        if (xj == 0)
+            continue;
+        
+        double *colJ = packedColumn(ioAP, inX.index(b));
+        double *compensationJ = packedColumn(ioCompensation, inX.index(b));
+        for (uint32_t a = 0; a <= b; a++)
+            compensatedAdd(colJ[inX.index(a)], compensationJ[inX.index(a)],
+                inX.value(a) * xj);
+    }
+}
+
+/**
+ * @brief Compensated element-wise addition of two vectors
+ *
+ * Matrices in packed storage are added in the same way.
+ */
+inline void compensatedAddVector(arma::Col<double> &ioA,
+    arma::Col<double> &ioCompensation, const arma::Col<double> &inB) {
+    
+    double *a = ioA.memptr();
+    double *compensation = ioCompensation.memptr();
+    const double *b = inB.memptr();
+    for (arma::u32 i = 0; i < ioA.n_elem; i++)
+        compensatedAdd(a[i], compensation[i], b[i]);
+}
+
+/**
+ * @brief Expand a symmetric matrix in packed storage into a full square
+ *     matrix
+ *
+ * @param inAP Matrix in packed storage
+ * @param outA Square matrix. Its number of rows determines the size.
+ */
+inline void unpackSymmetric(const double *inAP, arma::Mat<double> &outA) {
+    const arma::u32 n = outA.n_rows;
+    const double *colJ = inAP;
+    for (arma::u32 j = 0; j < n; colJ += ++j)
+        for (arma::u32 i = 0; i <= j; i++)
+            outA.at(i, j) = outA.at(j, i) = colJ[i];
+}
+
+} // namespace regress
+
+} // namespace modules
+
+} // namespace madlib
+
+#endif
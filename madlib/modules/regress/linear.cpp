@@ -7,16 +7,25 @@
  *//* ----------------------------------------------------------------------- */
 
 #include <madlib/modules/regress/linear.hpp>
+#include <madlib/modules/regress/linalg.hpp>
+#include <madlib/modules/regress/merge.hpp>
+#include <madlib/modules/regress/rows.hpp>
+#include <madlib/modules/regress/cholesky.hpp>
 #include <madlib/modules/prob/student.hpp>
 #include <madlib/utils/Reference.hpp>
 
+#include <algorithm>
+#include <limits>
+
 // Import names from Armadillo
 using arma::mat;
+using arma::colvec;
 using arma::as_scalar;
 
 namespace madlib {
 
 using utils::Reference;
+using utils::ThreadPool;
 
 namespace modules {
 
@@ -34,10 +43,47 @@ namespace regress {
  * containing scalars, a vector, and a matrix.
  *
  * Note: We assume that the DOUBLE PRECISION array is initialized by the
- * database with length at least 5, and all elemenets are 0.
+ * database with length at least 11, and all elemenets are 0.
+ *
+ * The first element is the version of the array layout. It is 0 only for the
+ * initial value, so a state written with a different layout (e.g., by an
+ * older version of this module) is rejected instead of misinterpreted.
+ *
+ * If batchSize is greater than 1, rows are not added to X^T X and X^T y one by
+ * one. Instead, they are first collected in yBlock and XBlock (one column per
+ * row), and every batchSize rows the block is added with a single rank-k
+ * update. Functions that read the accumulators have to call finalize() first.
+ *
+ * If isCompensated is set, all sums are accumulated with compensatedAdd(), and
+ * the error terms are kept in the *_comp members. With buffering, each block
+ * is first summed up with BLAS and then added with compensation. finalize()
+ * folds the error terms into the sums.
+ *
+ * @internal Array layout:
+ * - 0: layoutVersion (kLayoutVersion, or 0 if not yet initialized)
+ * - 1: numRows (number of rows seen so far, including buffered rows)
+ * - 2: widthOfX (number of independent variables)
+ * - 3: y_sum (sum of dependent variable)
+ * - 4: y_square_sum (sum of squares of dependent variable)
+ * - 5: batchSize (number of rows to buffer, 0 disables buffering)
+ * - 6: numBuffered (number of rows currently buffered)
+ * - 7: isCompensated (whether sums are compensated, 0 or 1)
+ * - 8: y_sum_comp (error term of y_sum)
+ * - 9: y_square_sum_comp (error term of y_square_sum)
+ * - 10: yBlock (buffered values of the dependent variable)
+ * - 10 + batchSize: XBlock (buffered independent variables)
+ * - 10 + (widthOfX + 1) * batchSize: X_transp_Y (X^T y)
+ * - 10 + (widthOfX + 1) * batchSize + widthOfX: X_transp_X (X^T X)
+ * - 10 + (widthOfX + 1) * batchSize + widthOfX + widthOfX (widthOfX + 1) / 2:
+ *   X_transp_Y_comp and X_transp_X_comp (error terms, only if isCompensated)
+ *
+ * X_transp_X and X_transp_X_comp are symmetric and kept in packed storage
+ * (see packedSize()). The final step unpacks X_transp_X.
  */
 class LinearRegression::TransitionState {
 public:
+    enum { kLayoutVersion = 1 };
+    
     /**
      * @internal Member initalization occurs in the order of declaration in the
      *      class (see ISO/IEC 14882:2003, Section 12.6.2). The order in the
@@ -46,16 +92,43 @@ public:
      */
     TransitionState(AnyValue inArg)
         : mStorage(inArg.copyIfImmutable()),
-          numRows(&mStorage[0]),
-          widthOfX(&mStorage[1]),
-          y_sum(&mStorage[2]),
-          y_square_sum(&mStorage[3]),
+          layoutVersion(&mStorage[0]),
+          numRows(&mStorage[1]),
+          widthOfX(&mStorage[2]),
+          y_sum(&mStorage[3]),
+          y_square_sum(&mStorage[4]),
+          batchSize(&mStorage[5]),
+          numBuffered(&mStorage[6]),
+          isCompensated(&mStorage[7]),
+          y_sum_comp(&mStorage[8]),
+          y_square_sum_comp(&mStorage[9]),
+          yBlock(
+            TransparentHandle::create(&mStorage[10]),
+            batchSize),
+          XBlock(
+            TransparentHandle::create(&mStorage[10 + batchSize]),
+            widthOfX, batchSize),
           X_transp_Y(
-            TransparentHandle::create(&mStorage[4]),
+            TransparentHandle::create(&mStorage[accumulatorsBegin(widthOfX, batchSize)]),
             widthOfX),
           X_transp_X(
-            TransparentHandle::create(&mStorage[4 + widthOfX]),
-            widthOfX, widthOfX) { }
+            TransparentHandle::create(
+                &mStorage[accumulatorsBegin(widthOfX, batchSize) + widthOfX]),
+            packedSize(widthOfX)),
+          X_transp_Y_comp(
+            TransparentHandle::create(&mStorage[
+                compensationBegin(widthOfX, batchSize, isCompensated)]),
+            compensationWidth(widthOfX, isCompensated)),
+          X_transp_X_comp(
+            TransparentHandle::create(&mStorage[
+                compensationBegin(widthOfX, batchSize, isCompensated)
+                + compensationWidth(widthOfX, isCompensated)]),
+            packedSize(compensationWidth(widthOfX, isCompensated))) {
+        
+        if (layoutVersion != 0 && layoutVersion != kLayoutVersion)
+            throw std::invalid_argument("Transition state has an unsupported "
+                "layout version");
+    }
 
     /**
      * We define this function so that we can use TransitionState in the argument
@@ -69,77 +142,309 @@ public:
      * @brief Initialize the transition state. Only called for first row.
      */
     inline void initialize(AllocatorSPtr inAllocator,
-        const uint16_t inWidthOfX) {
+        const uint16_t inWidthOfX, const uint16_t inBatchSize = 0,
+        const bool inIsCompensated = false) {
+        
+        uint64_t accBegin = accumulatorsBegin(inWidthOfX, inBatchSize);
+        uint64_t compBegin = compensationBegin(inWidthOfX, inBatchSize,
+            inIsCompensated);
+        uint16_t compWidth = compensationWidth(inWidthOfX, inIsCompensated);
         
-        mStorage.rebind(inAllocator, boost::extents[ arraySize(inWidthOfX) ]);
-        numRows.rebind(&mStorage[0]) = 0;
-        widthOfX.rebind(&mStorage[1]) = inWidthOfX;
-        y_sum.rebind(&mStorage[2]) = 0;
-        y_square_sum.rebind(&mStorage[3]) = 0;
+        uint64_t size = arraySize(inWidthOfX, inBatchSize, inIsCompensated);
+        if (size > std::numeric_limits<uint32_t>::max())
+            throw std::invalid_argument("Transition state would be too large");
+        
+        mStorage.rebind(inAllocator, boost::extents[ size ]);
+        layoutVersion.rebind(&mStorage[0]) = kLayoutVersion;
+        numRows.rebind(&mStorage[1]) = 0;
+        widthOfX.rebind(&mStorage[2]) = inWidthOfX;
+        y_sum.rebind(&mStorage[3]) = 0;
+        y_square_sum.rebind(&mStorage[4]) = 0;
+        batchSize.rebind(&mStorage[5]) = inBatchSize;
+        numBuffered.rebind(&mStorage[6]) = 0;
+        isCompensated.rebind(&mStorage[7]) = inIsCompensated;
+        y_sum_comp.rebind(&mStorage[8]) = 0;
+        y_square_sum_comp.rebind(&mStorage[9]) = 0;
+        yBlock.rebind(
+            TransparentHandle::create(&mStorage[10]),
+            inBatchSize);
+        XBlock.rebind(
+            TransparentHandle::create(&mStorage[10 + inBatchSize]),
+            inWidthOfX, inBatchSize);
         X_transp_Y.rebind(
-            TransparentHandle::create(&mStorage[4]),
+            TransparentHandle::create(&mStorage[accBegin]),
             inWidthOfX);
         X_transp_X.rebind(
-            TransparentHandle::create(&mStorage[4 + inWidthOfX]),
-            inWidthOfX, inWidthOfX);
+            TransparentHandle::create(&mStorage[accBegin + inWidthOfX]),
+            packedSize(inWidthOfX));
+        X_transp_Y_comp.rebind(
+            TransparentHandle::create(&mStorage[compBegin]),
+            compWidth);
+        X_transp_X_comp.rebind(
+            TransparentHandle::create(&mStorage[compBegin + compWidth]),
+            packedSize(compWidth));
+    }
+    
+    /**
+     * @brief Add a value of the dependent variable to y_sum and y_square_sum
+     */
+    inline void addY(const double inY) {
+        if (isCompensated) {
+            compensatedAdd(y_sum, y_sum_comp, inY);
+            compensatedAdd(y_square_sum, y_square_sum_comp, inY * inY);
+        } else {
+            y_sum += inY;
+            y_square_sum += inY * inY;
+        }
+    }
+    
+    /**
+     * @brief Add a row to X^T X and X^T y, either directly or via the buffer
+     *
+     * The caller is responsible for updating numRows, y_sum, and y_square_sum.
+     * The elements of \c inX are either of type double or float.
+     */
+    template <typename T>
+    inline void addRow(const double inY, const T *inX) {
+        if (batchSize <= 1) {
+            if (isCompensated) {
+                for (uint16_t i = 0; i < widthOfX; i++)
+                    compensatedAdd(X_transp_Y(i), X_transp_Y_comp(i),
+                        inX[i] * inY);
+                compensatedRankOneUpdate(X_transp_X.memptr(),
+                    X_transp_X_comp.memptr(), widthOfX, inX);
+            } else {
+                for (uint16_t i = 0; i < widthOfX; i++)
+                    X_transp_Y(i) += inX[i] * inY;
+                packedRankOneUpdate(X_transp_X.memptr(), widthOfX, inX);
+            }
+            return;
+        }
+        
+        yBlock(numBuffered) = inY;
+        std::copy(inX, inX + widthOfX, XBlock.colptr(numBuffered));
+        numBuffered++;
+        if (numBuffered == batchSize)
+            flush();
+    }
+    
+    /**
+     * @brief Add a sparse row to X^T X and X^T y
+     *
+     * Without buffering, only the elements that belong to non-zero
+     * independent variables are updated. With buffering, the row is expanded
+     * into the buffer.
+     */
+    inline void addRow(const double inY, const SparseVector_const &inX) {
+        if (batchSize <= 1) {
+            if (isCompensated) {
+                for (uint32_t k = 0; k < inX.n_nonzero; k++)
+                    compensatedAdd(X_transp_Y(inX.index(k)),
+                        X_transp_Y_comp(inX.index(k)), inX.value(k) * inY);
+                compensatedRankOneUpdate(X_transp_X.memptr(),
+                    X_transp_X_comp.memptr(), widthOfX, inX);
+            } else {
+                inX.addTo(X_transp_Y.memptr(), inY);
+                packedRankOneUpdate(X_transp_X.memptr(), widthOfX, inX);
+            }
+            return;
+        }
+        
+        yBlock(numBuffered) = inY;
+        inX.toDense(XBlock.colptr(numBuffered));
+        numBuffered++;
+        if (numBuffered == batchSize)
+            flush();
+    }
+    
+    /**
+     * @brief Add all buffered rows to X^T X and X^T y
+     */
+    inline void flush() {
+        if (numBuffered == 0)
+            return;
+        
+        const mat X(XBlock.memptr(), widthOfX, numBuffered,
+            false /* copy_aux_mem */, true /* strict */);
+        const colvec y(yBlock.memptr(), numBuffered,
+            false /* copy_aux_mem */, true /* strict */);
+        
+        if (isCompensated) {
+            colvec blockX_transp_Y = X * y;
+            colvec blockX_transp_X(packedSize(widthOfX));
+            blockX_transp_X.zeros();
+            packedRankKUpdate(blockX_transp_X.memptr(), widthOfX,
+                XBlock.memptr(), numBuffered);
+            
+            compensatedAddVector(X_transp_Y, X_transp_Y_comp, blockX_transp_Y);
+            compensatedAddVector(X_transp_X, X_transp_X_comp, blockX_transp_X);
+        } else {
+            X_transp_Y += X * y;
+            packedRankKUpdate(X_transp_X.memptr(), widthOfX, XBlock.memptr(),
+                numBuffered);
+        }
+        numBuffered = 0;
+    }
+    
+    /**
+     * @brief Prepare the state for the final step
+     *
+     * Adds all buffered rows and folds the error terms of compensated sums
+     * into the sums.
+     */
+    inline void finalize() {
+        flush();
+        if (!isCompensated)
+            return;
+        
+        y_sum += y_sum_comp;
+        y_square_sum += y_square_sum_comp;
+        X_transp_Y += X_transp_Y_comp;
+        X_transp_X += X_transp_X_comp;
+        y_sum_comp = 0;
+        y_square_sum_comp = 0;
+        X_transp_Y_comp.zeros();
+        X_transp_X_comp.zeros();
     }
     
     /**
      * @brief Merge with another TransitionState object
+     *
+     * X_transp_Y and X_transp_X are adjacent in the array, and so are their
+     * error terms, so each pair is merged with a single addRange(). Rows
+     * buffered in the other state are added to this state one by one.
      */
     TransitionState &operator+=(const TransitionState &inOtherState) {
-        if (mStorage.size() != inOtherState.mStorage.size())
+        if (mStorage.size() != inOtherState.mStorage.size() ||
+            widthOfX != inOtherState.widthOfX ||
+            batchSize != inOtherState.batchSize ||
+            isCompensated != inOtherState.isCompensated)
             throw std::logic_error("Internal error: Incompatible transition states");
+        
+        numRows += inOtherState.numRows;
+        if (isCompensated) {
+            compensatedAdd(y_sum, y_sum_comp, inOtherState.y_sum);
+            compensatedAdd(y_square_sum, y_square_sum_comp,
+                inOtherState.y_square_sum);
+            y_sum_comp += inOtherState.y_sum_comp;
+            y_square_sum_comp += inOtherState.y_square_sum_comp;
             
-        for (uint32_t i = 0; i < mStorage.size(); i++)
-            mStorage[i] += inOtherState.mStorage[i];
+            compensatedAddVector(X_transp_Y, X_transp_Y_comp,
+                inOtherState.X_transp_Y);
+            compensatedAddVector(X_transp_X, X_transp_X_comp,
+                inOtherState.X_transp_X);
+            addRange(mStorage, inOtherState.mStorage,
+                compensationBegin(widthOfX, batchSize, isCompensated),
+                numAccumulators(widthOfX));
+        } else {
+            y_sum += inOtherState.y_sum;
+            y_square_sum += inOtherState.y_square_sum;
+            addRange(mStorage, inOtherState.mStorage,
+                accumulatorsBegin(widthOfX, batchSize),
+                numAccumulators(widthOfX));
+        }
         
-        widthOfX = inOtherState.widthOfX;
+        for (uint16_t i = 0; i < inOtherState.numBuffered; i++)
+            addRow(inOtherState.yBlock(i), inOtherState.XBlock.colptr(i));
         return *this;
     }
         
 private:
-    static inline uint32_t arraySize(const uint16_t inWidthOfX) {
-        return 4 + inWidthOfX + inWidthOfX * inWidthOfX;
+    static inline uint64_t accumulatorsBegin(const uint16_t inWidthOfX,
+        const uint16_t inBatchSize) {
+        
+        return 10 + (static_cast<uint64_t>(inWidthOfX) + 1) * inBatchSize;
+    }
+
+    /**
+     * @internal If there are no error terms, the (empty) vector and matrix are
+     *     bound to the beginning of the array, because there is no element
+     *     behind the last accumulator.
+     */
+    static inline uint64_t compensationBegin(const uint16_t inWidthOfX,
+        const uint16_t inBatchSize, const bool inIsCompensated) {
+        
+        return inIsCompensated
+            ? accumulatorsBegin(inWidthOfX, inBatchSize)
+                + numAccumulators(inWidthOfX)
+            : 0;
+    }
+
+    static inline uint16_t compensationWidth(const uint16_t inWidthOfX,
+        const bool inIsCompensated) {
+        
+        return inIsCompensated ? inWidthOfX : 0;
+    }
+
+    /**
+     * @brief Number of elements of X_transp_Y and X_transp_X together
+     */
+    static inline uint64_t numAccumulators(const uint16_t inWidthOfX) {
+        return inWidthOfX + packedSize(inWidthOfX);
+    }
+
+    static inline uint64_t arraySize(const uint16_t inWidthOfX,
+        const uint16_t inBatchSize, const bool inIsCompensated) {
+        
+        return accumulatorsBegin(inWidthOfX, inBatchSize)
+            + (inIsCompensated ? 2 : 1) * numAccumulators(inWidthOfX);
     }
 
     Array<double> mStorage;
 
 public:
+    Reference<double, uint16_t> layoutVersion;
     Reference<double, uint64_t> numRows;
     Reference<double, uint16_t> widthOfX;
     Reference<double> y_sum;
     Reference<double> y_square_sum;
+    Reference<double, uint16_t> batchSize;
+    Reference<double, uint16_t> numBuffered;
+    Reference<double, bool> isCompensated;
+    Reference<double> y_sum_comp;
+    Reference<double> y_square_sum_comp;
+    DoubleCol yBlock;
+    DoubleMat XBlock;
     DoubleCol X_transp_Y;
-    DoubleMat X_transp_X;
+    DoubleCol X_transp_X;
+    DoubleCol X_transp_Y_comp;
+    DoubleCol X_transp_X_comp;
 };
 
 /**
  * @brief Compute the linear-regression coefficient as final step
  */
 AnyValue LinearRegression::coefFinal(AbstractDBInterface &db, AnyValue args) {
-    return final<kCoef>(db, args[0]);
+    TransitionState state = args[0].copyIfImmutable();
+    state.finalize();
+    return final<kCoef>(db, state);
 }
 
 /**
  * @brief Compute the coefficient of determination as final step
  */
 AnyValue LinearRegression::RSquareFinal(AbstractDBInterface &db, AnyValue args) {
-    return final<kRSquare>(db, args[0]);
+    TransitionState state = args[0].copyIfImmutable();
+    state.finalize();
+    return final<kRSquare>(db, state);
 }
 
 /**
  * @brief Compute the vector of t-statistics as final step
  */
 AnyValue LinearRegression::tStatsFinal(AbstractDBInterface &db, AnyValue args) {
-    return final<kTStats>(db, args[0]);
+    TransitionState state = args[0].copyIfImmutable();
+    state.finalize();
+    return final<kTStats>(db, state);
 }
 
 /**
  * @brief Compute the vector of p-values as final step
  */
 AnyValue LinearRegression::pValuesFinal(AbstractDBInterface &db, AnyValue args) {
-    return final<kPValues>(db, args[0]);
+    TransitionState state = args[0].copyIfImmutable();
+    state.finalize();
+    return final<kPValues>(db, state);
 }
 
 /**
@@ -148,6 +453,12 @@ AnyValue LinearRegression::pValuesFinal(AbstractDBInterface &db, AnyValue args)
  * We update: the number of rows $n$, the partial sums \f$ \sum_{i=1}^n y_i \f$
  * and \f$ \sum_{i=1}^n y_i^2 \f$, the matrix \f$ X^T X \F$, and the vector
  * \f$ X^T \boldsymbol y \f$.
+ *
+ * An optional fourth argument specifies the number of rows that are buffered
+ * before they are added to \f$ X^T X \f$ and \f$ X^T \boldsymbol y \f$ in
+ * one block. An optional fifth argument specifies whether all sums are
+ * accumulated with compensated summation. Both are only read for the first
+ * row.
  */
 AnyValue LinearRegression::transition(AbstractDBInterface &db, AnyValue args) {
     AnyValue::iterator arg(args);
@@ -155,19 +466,87 @@ AnyValue LinearRegression::transition(AbstractDBInterface &db, AnyValue args) {
     // Arguments from SQL call. Immutable values passed by reference should be
     // instantiated from the respective <tt>_const</tt> class. Otherwise, the
     // abstraction layer will perform a deep copy (i.e., waste unnecessary
-    // processor cycles).
+    // processor cycles). We use getAs() wherever possible, because this avoids
+    // creating temporary AnyValue objects for every row.
+    TransitionState state = *arg++;
+    double y = arg++.getAs<double>();
+    DoubleRow_const x = arg++.getAs<DoubleRow_const>();
+    
+    return transitionStep(db, state, y, x, arg, args.size() - 3);
+}
+
+/**
+ * @brief Perform the linear-regression transition step for a single-precision
+ *     row
+ *
+ * The arguments are as for transition(), except that the independent
+ * variables are of type REAL[]. They are not converted into a double-precision
+ * copy, but all sums are still accumulated in double precision.
+ */
+AnyValue LinearRegression::floatTransition(AbstractDBInterface &db,
+    AnyValue args) {
+    
+    AnyValue::iterator arg(args);
+    
+    TransitionState state = *arg++;
+    double y = arg++.getAs<double>();
+    FloatRow_const x = arg++.getAs<Array_const<float> >();
+    
+    return transitionStep(db, state, y, x, arg, args.size() - 3);
+}
+
+/**
+ * @brief Perform the linear-regression transition step for a sparse row
+ *
+ * Instead of one array, the independent variables are given by three
+ * arguments: The one-based positions of the non-zero elements, their values,
+ * and the number of independent variables. The optional arguments are the
+ * same as for transition().
+ */
+AnyValue LinearRegression::sparseTransition(AbstractDBInterface &db,
+    AnyValue args) {
+    
+    AnyValue::iterator arg(args);
+    
     TransitionState state = *arg++;
-    double y = *arg++;
-    DoubleRow_const x = *arg++;
+    double y = arg++.getAs<double>();
+    SparseVector_const x = sparseRowArg(arg);
+    
+    return transitionStep(db, state, y, x, arg, args.size() - 5);
+}
+
+/**
+ * @brief Transition step common to dense and sparse rows
+ *
+ * @param ioArg Iterator pointing to the first optional argument
+ * @param inNumOptionalArgs Number of optional arguments that were passed
+ */
+template <class Row>
+AnyValue LinearRegression::transitionStep(AbstractDBInterface &db,
+    TransitionState &state, const double y, const Row &x,
+    AnyValue::iterator &ioArg, const unsigned int inNumOptionalArgs) {
+    
+    if (state.numRows == 0) {
+        if (x.n_elem > std::numeric_limits<uint16_t>::max())
+            throw std::invalid_argument("Number of independent variables "
+                "cannot be larger than 65535");
+        
+        int32_t batchSize = inNumOptionalArgs > 0
+            ? ioArg++.getAs<int32_t>() : 0;
+        if (batchSize < 0 || batchSize > std::numeric_limits<uint16_t>::max())
+            throw std::invalid_argument("Batch size must be between 0 and 65535");
+        bool isCompensated = inNumOptionalArgs > 1
+            ? ioArg.getAs<bool>() : false;
+        
+        state.initialize(db.allocator(AbstractAllocator::kAggregate), x.n_elem,
+            batchSize, isCompensated);
+    }
+    if (x.n_elem != state.widthOfX)
+        throw std::invalid_argument("Inconsistent numbers of independent variables");
     
-    // Now do the transition step.
-    if (state.numRows == 0)
-        state.initialize(db.allocator(AbstractAllocator::kAggregate), x.n_elem);
     state.numRows++;
-    state.y_sum += y;
-    state.y_square_sum += y * y;
-    state.X_transp_Y += trans(x) * y;
-    state.X_transp_X += trans(x) * x;
+    state.addY(y);
+    state.addRow(y, rowElements(x));
         
     return state;
 }
@@ -176,27 +555,64 @@ AnyValue LinearRegression::transition(AbstractDBInterface &db, AnyValue args) {
  * @brief Perform the perliminary aggregation function: Merge transition states
  */
 AnyValue LinearRegression::preliminary(AbstractDBInterface &db, AnyValue args) {
-    TransitionState stateLeft = args[0].copyIfImmutable();
-    const TransitionState stateRight = args[1];
-    
-    // Merge states together and return
-    stateLeft += stateRight;
-    return stateLeft;
+    return mergeStates<TransitionState>(args);
+}
+
+/**
+ * @brief Number of threads for the final step
+ *
+ * The Cholesky decomposition takes \f$ O(n^3) \f$ time, so threads only pay
+ * off for wide models.
+ */
+static unsigned int numThreadsForFinal(const uint16_t inWidthOfX) {
+    if (inWidthOfX < 256)
+        return 1;
+    return std::min(ThreadPool::numProcessors(), 4u);
+}
+
+/**
+ * @brief Compute all statistics at once as final step
+ *
+ * The result is a record of coefficients, coefficient of determination,
+ * t-statistics, and p-values. It is computed from a single factorization of
+ * \f$ X^T X \f$.
+ */
+AnyValue LinearRegression::statsFinal(AbstractDBInterface &db, AnyValue args) {
+    TransitionState state = args[0].copyIfImmutable();
+    state.finalize();
+    return final<kAll>(db, state);
 }
 
 /**
  * @brief Perform the linear-regression final step
  *
+ * \f$ X^T X \f$ is factorized only once with a Cholesky decomposition, from
+ * which both the coefficients and the diagonal of \f$ (X^T X)^{-1} \f$ are
+ * derived. Only if \f$ X^T X \f$ is rank-deficient, we fall back to the
+ * pseudo-inverse.
+ *
  * @internal We pass \c what as a compile-time argument.
  */
 template <LinearRegression::What what>
 AnyValue LinearRegression::final(AbstractDBInterface &db,
     const LinearRegression::TransitionState &state) {
 
+    mat X_transp_X(state.widthOfX, state.widthOfX);
+    unpackSymmetric(state.X_transp_X.memptr(), X_transp_X);
+    CholeskyDecomposition cholesky(X_transp_X,
+        numThreadsForFinal(state.widthOfX));
+    
+    mat pinv_of_X_transp_X;
+    if (!cholesky.isPositiveDefinite())
+        pinv_of_X_transp_X = pinv(X_transp_X);
+
     // Vector of coefficients: For efficiency reasons, we want to return this
     // by reference, so we need to bind to db memory
     DoubleCol coef(db.allocator(), state.widthOfX);
-    coef = pinv(state.X_transp_X) * state.X_transp_Y;
+    if (cholesky.isPositiveDefinite())
+        cholesky.solve(state.X_transp_Y.memptr(), coef.memptr());
+    else
+        coef = pinv_of_X_transp_X * state.X_transp_Y;
     if (what == kCoef)
         return coef;
     
@@ -208,37 +624,56 @@ AnyValue LinearRegression::final(AbstractDBInterface &db,
           );
 
     // coefficient of determination
-    if (what == kRSquare) {
+    double rSquare = 0;
+    if (what == kRSquare || what == kAll) {
         // total sum of squares
         double tss
             = state.y_square_sum
                 - ((state.y_sum * state.y_sum) / state.numRows);
     
-        return ess / tss;
+        rSquare = ess / tss;
+        if (what == kRSquare)
+            return rSquare;
     }
 
     // Variance is also called the mean square error
 	double variance = ess / (state.numRows - state.widthOfX);
 
-    // Precompute (X^T * X)^{-1}
-    mat inverse_of_X_transp_X = inv(state.X_transp_X);
+    // Precompute the diagonal of (X^T * X)^{-1}
+    colvec diagonal_of_inverse(state.widthOfX);
+    if (cholesky.isPositiveDefinite())
+        cholesky.inverseDiagonal(diagonal_of_inverse.memptr());
+    else
+        for (int i = 0; i < state.widthOfX; i++)
+            diagonal_of_inverse(i) = pinv_of_X_transp_X(i,i);
     
     // Vector of t-statistics: For efficiency reasons, we want to return this
     // by reference, so we need to bind to db memory
     DoubleCol tStats(db.allocator(), state.widthOfX);
     for (int i = 0; i < state.widthOfX; i++)
-        tStats(i) = coef(i) / std::sqrt( variance * inverse_of_X_transp_X(i,i) );
+        tStats(i) = coef(i) / std::sqrt( variance * diagonal_of_inverse(i) );
     if (what == kTStats)
         return tStats;
     
     // Vector of p-values: For efficiency reasons, we want to return this
     // by reference, so we need to bind to db memory
+    // We use the lower tail Pr[T <= -|t|], which is accurate also for tiny
+    // p-values, and evaluate all of them with one call
     DoubleCol pValues(db.allocator(), state.widthOfX);
     for (int i = 0; i < state.widthOfX; i++)
-        pValues(i) = 2. * (1. - studentT_cdf(
-                                    state.numRows - state.widthOfX,
-                                    std::fabs( tStats(i) )));
-    return pValues;
+        pValues(i) = -std::fabs( tStats(i) );
+    studentT_cdf(state.numRows - state.widthOfX, pValues.memptr(),
+        pValues.memptr(), state.widthOfX);
+    pValues *= 2.;
+    if (what == kPValues)
+        return pValues;
+    
+    AnyValueVector stats;
+    stats.push_back(coef);
+    stats.push_back(rSquare);
+    stats.push_back(tStats);
+    stats.push_back(pValues);
+    return stats;
 }
 
 } // namespace regress
@@ -16,20 +16,28 @@ namespace modules {
 namespace regress {
 
 struct LinearRegression {
-    enum What { kCoef, kRSquare, kTStats, kPValues };
+    enum What { kCoef, kRSquare, kTStats, kPValues, kAll };
     
     class TransitionState;
     
     static AnyValue transition(AbstractDBInterface &db, AnyValue args);
+    static AnyValue floatTransition(AbstractDBInterface &db, AnyValue args);
+    static AnyValue sparseTransition(AbstractDBInterface &db, AnyValue args);
     static AnyValue preliminary(AbstractDBInterface &db, AnyValue args);
     
     static AnyValue coefFinal(AbstractDBInterface &db, AnyValue args);
     static AnyValue RSquareFinal(AbstractDBInterface &db, AnyValue args);
     static AnyValue tStatsFinal(AbstractDBInterface &db, AnyValue args);
     static AnyValue pValuesFinal(AbstractDBInterface &db, AnyValue args);
+    static AnyValue statsFinal(AbstractDBInterface &db, AnyValue args);
     
     template <What what>
     static AnyValue final(AbstractDBInterface &db, const TransitionState &state);
+    
+    template <class Row>
+    static AnyValue transitionStep(AbstractDBInterface &db,
+        TransitionState &state, const double y, const Row &x,
+        AnyValue::iterator &ioArg, const unsigned int inNumOptionalArgs);
 };
 
 } // namespace regress
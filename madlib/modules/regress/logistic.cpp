@@ -4,16 +4,26 @@
  *
  * @brief Logistic-Regression functions
  *
- * We implement the conjugate-gradient method and the iteratively-reweighted-
- * least-squares method.
+ * We implement the conjugate-gradient method, the limited-memory BFGS method,
+ * stochastic gradient descent, and the iteratively-reweighted-least-squares
+ * method.
  *
  *//* ----------------------------------------------------------------------- */
 
 #include <madlib/modules/regress/logistic.hpp>
+#include <madlib/modules/regress/linalg.hpp>
+#include <madlib/modules/regress/merge.hpp>
+#include <madlib/modules/regress/rows.hpp>
+#include <madlib/modules/regress/sigmoid.hpp>
 #include <madlib/utils/Reference.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
 // Import names from Armadillo
 using arma::trans;
+using arma::mat;
 using arma::colvec;
 using arma::as_scalar;
 
@@ -87,7 +97,7 @@ public:
      * This function is only called for the first iteration, for the first row.
      */
     inline void initialize(AllocatorSPtr inAllocator,
-        const uint16_t inWidthOfX) {
+        const uint32_t inWidthOfX) {
         
         mStorage.rebind(inAllocator, boost::extents[ arraySize(inWidthOfX) ]);
         iteration.rebind(&mStorage[0]) = 0;
@@ -142,15 +152,15 @@ public:
     }
 
 private:
-    static inline uint32_t arraySize(const uint16_t inWidthOfX) {
-        return 6 + 4 * inWidthOfX;
+    static inline uint64_t arraySize(const uint32_t inWidthOfX) {
+        return 6 + 4 * static_cast<uint64_t>(inWidthOfX);
     }
 
     Array<double> mStorage;
 
 public:
     Reference<double, uint32_t> iteration;
-    Reference<double, uint16_t> widthOfX;
+    Reference<double, uint32_t> widthOfX;
     DoubleCol coef;
     DoubleCol dir;
     DoubleCol grad;
@@ -163,50 +173,106 @@ public:
 };
 
 /**
- * @brief Logistic function
+ * @brief Perform the logistic-regression transition step
  */
-static double sigma(double x) {
-	return 1. / (1. + std::exp(-x));
+AnyValue LogisticRegressionCG::transition(AbstractDBInterface &db, AnyValue args) {
+    AnyValue::iterator arg(args);
+    
+    // Initialize Arguments from SQL call
+    State state = *arg++;
+    double y = arg++.getAs<bool>() ? 1. : -1.;
+    DoubleRow_const x = arg++.getAs<DoubleRow_const>();
+    
+    return transitionStep(db, state, y, x, arg, args.size() - 4);
 }
 
 /**
- * @brief Perform the logistic-regression transition step
+ * @brief Perform the conjugate-gradient transition step for a single-precision row
+ *
+ * The arguments are as for transition(), except that the independent
+ * variables are of type REAL[].
  */
-AnyValue LogisticRegressionCG::transition(AbstractDBInterface &db, AnyValue args) {
+AnyValue LogisticRegressionCG::floatTransition(AbstractDBInterface &db,
+    AnyValue args) {
+    
+    AnyValue::iterator arg(args);
+    
+    State state = *arg++;
+    double y = arg++.getAs<bool>() ? 1. : -1.;
+    FloatRow_const x = arg++.getAs<Array_const<float> >();
+    
+    return transitionStep(db, state, y, x, arg, args.size() - 4);
+}
+
+/**
+ * @brief Perform the conjugate-gradient transition step for a sparse row
+ *
+ * The independent variables are given by their one-based positions, their
+ * values, and their number. Otherwise, the arguments are as for transition().
+ */
+AnyValue LogisticRegressionCG::sparseTransition(AbstractDBInterface &db,
+    AnyValue args) {
+    
     AnyValue::iterator arg(args);
     
-    // Initialize Arguments from SQL call
     State state = *arg++;
-    double y = *arg++ ? 1. : -1.;
-    DoubleRow_const x = *arg++;
+    double y = arg++.getAs<bool>() ? 1. : -1.;
+    SparseVector_const x = sparseRowArg(arg);
+    
+    return transitionStep(db, state, y, x, arg, args.size() - 6);
+}
+
+/**
+ * @brief Transition step common to dense and sparse rows
+ *
+ * @param arg Iterator pointing to the previous state
+ * @param inNumOptionalArgs Number of arguments after the previous state
+ */
+template <class Row>
+AnyValue LogisticRegressionCG::transitionStep(AbstractDBInterface &db,
+    State &state, const double y, const Row &x, AnyValue::iterator &arg,
+    const unsigned int inNumOptionalArgs) {
+    
     if (state.numRows == 0) {
-        state.initialize(db.allocator(AbstractAllocator::kAggregate), x.n_elem);
-        if (!arg->isNull()) {
+        if (arg->isNull()) {
+            state.initialize(db.allocator(AbstractAllocator::kAggregate),
+                x.n_elem);
+        } else {
+            // The previous state may come from an earlier run (warm start),
+            // so its size determines the size of the new state
             const State previousState = *arg;
             
+            state.initialize(db.allocator(AbstractAllocator::kAggregate),
+                previousState.widthOfX);
             state = previousState;
             state.reset();
         }
     }
+    if (x.n_elem != state.widthOfX)
+        throw std::invalid_argument("Inconsistent numbers of independent variables");
     
     // Now do the transition step
     state.numRows++;
 	
-    double xc = as_scalar( x * state.coef );
-	double xd = as_scalar( x * state.dir );
+    double xc = rowDot(x, state.coef);
+	double xd = rowDot(x, state.dir);
+    
+    // Note that sigma(x) sigma(-x) = sigma(y x) sigma(-y x) because y = +/-1
+    double sigmaYXc, sigmaNegYXc;
+    double logSigmaYXc = logisticTerms(y * xc, sigmaYXc, sigmaNegYXc);
     
     if (state.iteration % 2 == 0)
-        state.gradNew += sigma(-y * xc) * y * trans(x);
+        addScaledRow(state.gradNew, sigmaNegYXc * y, x);
     else
         // Note that 1 - sigma(x) = sigma(-x)
-        state.dTHd -= sigma(xc) * sigma(-xc) * xd * xd;
+        state.dTHd -= sigmaYXc * sigmaNegYXc * xd * xd;
     
     //          n
     //         --
     // l(c) = -\  log(1 + exp(-y_i * c^T x_i))
     //         /_
     //         i=1
-    state.logLikelihood -= std::log( 1. + std::exp(-y * xc) );
+    state.logLikelihood += logSigmaYXc;
     return state;
 }
 
@@ -214,12 +280,7 @@ AnyValue LogisticRegressionCG::transition(AbstractDBInterface &db, AnyValue args
  * @brief Perform the perliminary aggregation function: Merge transition states
  */
 AnyValue LogisticRegressionCG::preliminary(AbstractDBInterface &db, AnyValue args) {
-    State stateLeft = args[0].copyIfImmutable();
-    const State stateRight = args[1];
-    
-    // Merge states together and return
-    stateLeft += stateRight;
-    return stateLeft;
+    return mergeStates<State>(args);
 }
 
 /**
@@ -287,42 +348,52 @@ AnyValue LogisticRegressionCG::coef(AbstractDBInterface &db, AnyValue args) {
 }
 
 /**
- * @brief Inter- and intra-iteration state for iteratively-reweighted-least-
- *        squares method for logistic regression
+ * @brief Inter- and intra-iteration state for the fused conjugate-gradient
+ *        method for logistic regression
  *
- * TransitionState encapsualtes the transition state during the
- * logistic-regression aggregate function. To the database, the state is
- * exposed as a single DOUBLE PRECISION array, to the C++ code it is a proper
- * object containing scalars, a vector, and a matrix.
+ * In contrast to LogisticRegressionCG::State, one iteration is a single
+ * aggregate-function call: The transition step accumulates both the gradient
+ * at the current coefficients and the Hessian-vector product along the
+ * current direction.
  *
  * Note: We assume that the DOUBLE PRECISION array is initialized by the
- * database with length at least 3, and all elemenets are 0.
+ * database with length at least 6, and all elemenets are 0.
  *
  * @internal Array layout (iteration refers to one aggregate-function call):
  * Inter-iteration components (updated in final function):
- * - 0: widthOfX (numer of coefficients)
- * - 1: coef (vector of coefficients)
+ * - 0: iteration (current iteration)
+ * - 1: widthOfX (numer of coefficients)
+ * - 2: coef (vector of coefficients)
+ * - 2 + widthOfX: dir (direction)
+ * - 2 + 2 * widthOfX: grad (predicted gradient at coef)
+ * - 2 + 3 * widthOfX: beta (scale factor)
  *
  * Intra-iteration components (updated in transition step):
- * - 1 + widthOfX: numRows (number of rows already processed in this iteration)
- * - 2 + widthOfX: X_transp_Az (X^T A z)
- * - 2 + 2 * widthOfX: X_transp_AX (X^T A X)
- * - 2 + widthOfX^2 + 2 * widthOfX: logLikelihood ( ln(l(c)) )
+ * - 3 + 3 * widthOfX: numRows (number of rows already processed in this iteration)
+ * - 4 + 3 * widthOfX: gradNew (intermediate value for gradient)
+ * - 4 + 4 * widthOfX: Hd (intermediate value for H * d)
+ * - 4 + 5 * widthOfX: logLikelihood ( ln(l(c)) )
  */
-class LogisticRegressionIRLS::State {
+class LogisticRegressionFCG::State {
 public:
     State(AnyValue inArg)
         : mStorage(inArg.copyIfImmutable()),
-          widthOfX(&mStorage[0]),
-          coef(TransparentHandle::create(&mStorage[1]),
+          iteration(&mStorage[0]),
+          widthOfX(&mStorage[1]),
+          coef(TransparentHandle::create(&mStorage[2]),
                widthOfX),
-        
-          numRows(&mStorage[1 + widthOfX]),
-          X_transp_Az(TransparentHandle::create(&mStorage[2 + widthOfX]),
+          dir(TransparentHandle::create(&mStorage[2 + widthOfX]),
               widthOfX),
-          X_transp_AX(TransparentHandle::create(&mStorage[2 + 2 * widthOfX]),
-              widthOfX, widthOfX),
-          logLikelihood(&mStorage[2 + widthOfX * widthOfX + 2 * widthOfX])
+          grad(TransparentHandle::create(&mStorage[2 + 2 * widthOfX]),
+              widthOfX),
+          beta(&mStorage[2 + 3 * widthOfX]),
+          
+          numRows(&mStorage[3 + 3 * widthOfX]),
+          gradNew(TransparentHandle::create(&mStorage[4 + 3 * widthOfX]),
+                  widthOfX),
+          Hd(TransparentHandle::create(&mStorage[4 + 4 * widthOfX]),
+             widthOfX),
+          logLikelihood(&mStorage[4 + 5 * widthOfX])
         { }
     
     /**
@@ -334,24 +405,30 @@ public:
     }
     
     /**
-     * @brief Initialize the conjugate-gradient state.
+     * @brief Initialize the fused conjugate-gradient state.
      * 
      * This function is only called for the first iteration, for the first row.
      */
     inline void initialize(AllocatorSPtr inAllocator,
-        const uint16_t inWidthOfX) {
+        const uint32_t inWidthOfX) {
         
         mStorage.rebind(inAllocator, boost::extents[ arraySize(inWidthOfX) ]);
-        widthOfX.rebind(&mStorage[0]) = inWidthOfX;
-        coef.rebind(TransparentHandle::create(&mStorage[1]),
+        iteration.rebind(&mStorage[0]) = 0;
+        widthOfX.rebind(&mStorage[1]) = inWidthOfX;
+        coef.rebind(TransparentHandle::create(&mStorage[2]),
                     widthOfX).zeros();
-        
-        numRows.rebind(&mStorage[1 + widthOfX]);
-        X_transp_Az.rebind(TransparentHandle::create(&mStorage[2 + widthOfX]),
-                           widthOfX);
-        X_transp_AX.rebind(TransparentHandle::create(&mStorage[2 + 2 * widthOfX]),
-                           widthOfX, widthOfX);
-        logLikelihood.rebind(&mStorage[2 + widthOfX * widthOfX + 2 * widthOfX]);
+        dir.rebind(TransparentHandle::create(&mStorage[2 + widthOfX]),
+                   widthOfX).zeros();
+        grad.rebind(TransparentHandle::create(&mStorage[2 + 2 * widthOfX]),
+                    widthOfX).zeros();
+        beta.rebind(&mStorage[2 + 3 * widthOfX]) = 0;
+
+        numRows.rebind(&mStorage[3 + 3 * widthOfX]);
+        gradNew.rebind(TransparentHandle::create(&mStorage[4 + 3 * widthOfX]),
+                       widthOfX);
+        Hd.rebind(TransparentHandle::create(&mStorage[4 + 4 * widthOfX]),
+                  widthOfX);
+        logLikelihood.rebind(&mStorage[4 + 5 * widthOfX]);
         reset();
     }
     
@@ -372,8 +449,8 @@ public:
             throw std::logic_error("Internal error: Incompatible transition states");
         
         numRows += inOtherState.numRows;
-        X_transp_Az += inOtherState.X_transp_Az;
-        X_transp_AX += inOtherState.X_transp_AX;
+        gradNew += inOtherState.gradNew;
+        Hd += inOtherState.Hd;
         logLikelihood += inOtherState.logLikelihood;
         return *this;
     }
@@ -383,85 +460,1448 @@ public:
      */
     inline void reset() {
         numRows = 0;
-        X_transp_Az.zeros();
-        X_transp_AX.zeros();
+        gradNew.zeros();
+        Hd.zeros();
         logLikelihood = 0;
     }
-    
+
 private:
-    static inline uint32_t arraySize(const uint16_t inWidthOfX) {
-        return 3 + inWidthOfX * inWidthOfX + 2 * inWidthOfX;
+    static inline uint64_t arraySize(const uint32_t inWidthOfX) {
+        return 5 + 5 * static_cast<uint64_t>(inWidthOfX);
     }
 
     Array<double> mStorage;
 
 public:
-    Reference<double, uint16_t> widthOfX;
+    Reference<double, uint32_t> iteration;
+    Reference<double, uint32_t> widthOfX;
     DoubleCol coef;
-
+    DoubleCol dir;
+    DoubleCol grad;
+    Reference<double> beta;
+    
     Reference<double, uint64_t> numRows;
-    DoubleCol X_transp_Az;
-    DoubleMat X_transp_AX;
+    DoubleCol gradNew;
+    DoubleCol Hd;
     Reference<double> logLikelihood;
 };
 
-AnyValue LogisticRegressionIRLS::transition(AbstractDBInterface &db,
+/**
+ * @brief Perform the fused conjugate-gradient transition step
+ */
+AnyValue LogisticRegressionFCG::transition(AbstractDBInterface &db,
     AnyValue args) {
+    
     AnyValue::iterator arg(args);
     
     // Initialize Arguments from SQL call
     State state = *arg++;
-    double y = *arg++ ? 1. : -1.;
-    DoubleRow_const x = *arg++;
+    double y = arg++.getAs<bool>() ? 1. : -1.;
+    DoubleRow_const x = arg++.getAs<DoubleRow_const>();
+    
+    return transitionStep(db, state, y, x, arg, args.size() - 4);
+}
+
+/**
+ * @brief Perform the fused conjugate-gradient transition step for a single-precision row
+ *
+ * The arguments are as for transition(), except that the independent
+ * variables are of type REAL[].
+ */
+AnyValue LogisticRegressionFCG::floatTransition(AbstractDBInterface &db,
+    AnyValue args) {
+    
+    AnyValue::iterator arg(args);
+    
+    State state = *arg++;
+    double y = arg++.getAs<bool>() ? 1. : -1.;
+    FloatRow_const x = arg++.getAs<Array_const<float> >();
+    
+    return transitionStep(db, state, y, x, arg, args.size() - 4);
+}
+
+/**
+ * @brief Perform the fused conjugate-gradient transition step for a sparse row
+ *
+ * The independent variables are given by their one-based positions, their
+ * values, and their number. Otherwise, the arguments are as for transition().
+ */
+AnyValue LogisticRegressionFCG::sparseTransition(AbstractDBInterface &db,
+    AnyValue args) {
+    
+    AnyValue::iterator arg(args);
+    
+    State state = *arg++;
+    double y = arg++.getAs<bool>() ? 1. : -1.;
+    SparseVector_const x = sparseRowArg(arg);
+    
+    return transitionStep(db, state, y, x, arg, args.size() - 6);
+}
+
+/**
+ * @brief Transition step common to dense and sparse rows
+ *
+ * @param arg Iterator pointing to the previous state
+ * @param inNumOptionalArgs Number of arguments after the previous state
+ */
+template <class Row>
+AnyValue LogisticRegressionFCG::transitionStep(AbstractDBInterface &db,
+    State &state, const double y, const Row &x, AnyValue::iterator &arg,
+    const unsigned int inNumOptionalArgs) {
+    
     if (state.numRows == 0) {
-        state.initialize(db.allocator(AbstractAllocator::kAggregate), x.n_elem);
-        if (!arg->isNull()) {
+        if (arg->isNull()) {
+            state.initialize(db.allocator(AbstractAllocator::kAggregate),
+                x.n_elem);
+        } else {
             const State previousState = *arg;
             
+            state.initialize(db.allocator(AbstractAllocator::kAggregate),
+                previousState.widthOfX);
             state = previousState;
             state.reset();
         }
     }
+    if (x.n_elem != state.widthOfX)
+        throw std::invalid_argument("Inconsistent numbers of independent variables");
     
     // Now do the transition step
     state.numRows++;
-
-    // xc = x_i c
-    double xc = as_scalar( x * state.coef );
-        
-    // a_i = sigma(x_i c) sigma(-x_i c)
-    double a = sigma(xc) * sigma(-xc);
+	
+    double xc = rowDot(x, state.coef);
+	double xd = rowDot(x, state.dir);
+    
+    double sigmaYXc, sigmaNegYXc;
+    double logSigmaYXc = logisticTerms(y * xc, sigmaYXc, sigmaNegYXc);
+    
+    addScaledRow(state.gradNew, sigmaNegYXc * y, x);
     
-    // Note: sigma(-x) = 1 - sigma(x).
-    //
-    //             sigma(-y_i x_i c) y_i
-    // z = x_i c + ---------------------
-    //                     a_i
-    double z = xc + sigma(-y * xc) * y / a;
-
-    state.X_transp_Az += trans(x) * a * z;
-    state.X_transp_AX += trans(x) * a * x;
-        
-    // We use state.sumy to store the log likelihood.
     //          n
     //         --
-    // l(c) = -\  ln(1 + exp(-y_i * c^T x_i))
+    // H d = - \  sigma(x_i c) sigma(-x_i c) (x_i^T d) x_i
     //         /_
     //         i=1
-    state.logLikelihood -= std::log( 1. + std::exp(-y * xc) );
+    addScaledRow(state.Hd, -sigmaYXc * sigmaNegYXc * xd, x);
+    
+    state.logLikelihood += logSigmaYXc;
     return state;
 }
 
 /**
  * @brief Perform the perliminary aggregation function: Merge transition states
  */
-AnyValue LogisticRegressionIRLS::preliminary(AbstractDBInterface &db, AnyValue args) {
-    State stateLeft = args[0].copyIfImmutable();
+AnyValue LogisticRegressionFCG::preliminary(AbstractDBInterface &db,
+    AnyValue args) {
+    return mergeStates<State>(args);
+}
+
+/**
+ * @brief Perform the fused conjugate-gradient final step
+ *
+ * The final step first moves the coefficients along the current direction,
+ * using the exact gradient and curvature at the current coefficients. The
+ * gradient at the new coefficients is then predicted from the quadratic model,
+ * \f$ g_{k+1} \approx g_k + t_k H_k d_k \f$, and used to compute the next
+ * direction just like LogisticRegressionCG::final(). The next iteration
+ * evaluates the exact gradient at the new coefficients, so prediction errors
+ * do not accumulate.
+ */
+AnyValue LogisticRegressionFCG::final(AbstractDBInterface &db, AnyValue args) {
+    // Argument from SQL call
+    State state = args[0].copyIfImmutable();
+    
+    // d_k^T H_k d_k is 0 in the first iteration (where d_0 = 0) and negative
+    // otherwise
+    double dTHd = dot(state.dir, state.Hd);
+    if (dTHd < 0) {
+		//            g_k^T d_k
+		// alpha_k = -------------
+		//           d_k^T H_k d_k
+        //
+		// c_{k+1} = c_k - alpha_k * d_k
+        double alpha = dot(state.gradNew, state.dir) / dTHd;
+        state.coef -= alpha * state.dir;
+        
+        // g_{k+1} = g_k - alpha_k * H_k d_k (predicted)
+        colvec gradPredicted = state.gradNew - alpha * state.Hd;
+        
+		//            g_{k+1}^T (g_{k+1} - g_k)
+		// beta_k = -------------------------
+		//          d_k^T (g_{k+1} - g_k)
+        colvec gradPredictedMinusGrad = gradPredicted - state.gradNew;
+        state.beta
+            = dot(gradPredicted, gradPredictedMinusGrad)
+            / dot(state.dir, gradPredictedMinusGrad);
+        
+        // d_{k+1} = g_{k+1} - beta_k * d_k
+        state.dir = gradPredicted - state.beta * state.dir;
+        state.grad = gradPredicted;
+    } else {
+        state.beta = 0;
+        state.dir = state.gradNew;
+        state.grad = state.gradNew;
+    }
+    
+    // Restart with steepest ascent if the new direction is not an ascent
+    // direction
+    if (dot(state.grad, state.dir) <= 0)
+        state.dir = state.grad;
+    
+    state.iteration++;
+    return state;
+}
+
+/**
+ * @brief Return the difference in log-likelihood between two states
+ *
+ * The first iteration only determines the initial direction and does not
+ * change the coefficients, so the first two states always have the same
+ * log-likelihood. Their distance is therefore infinite.
+ */
+AnyValue LogisticRegressionFCG::distance(AbstractDBInterface &db,
+    AnyValue args) {
+    
+    const State stateLeft = args[0];
     const State stateRight = args[1];
+
+    if (std::min<uint32_t>(stateLeft.iteration, stateRight.iteration) <= 1)
+        return std::numeric_limits<double>::infinity();
+    return std::abs(stateLeft.logLikelihood - stateRight.logLikelihood);
+}
+
+/**
+ * @brief Return the coefficients of the state
+ */
+AnyValue LogisticRegressionFCG::coef(AbstractDBInterface &db, AnyValue args) {
+    const State state = args[0];
+
+    return state.coef;
+}
+
+/**
+ * @brief Inter- and intra-iteration state for the limited-memory BFGS method
+ *        for logistic regression
+ *
+ * Each iteration (one aggregate-function call) evaluates the log-likelihood
+ * and its gradient at one trial point. The final step either accepts the trial
+ * point and computes a new search direction from the last historySize
+ * correction pairs (the two-loop recursion), or it backtracks along the
+ * current direction.
+ *
+ * Note: We assume that the DOUBLE PRECISION array is initialized by the
+ * database with length at least 11, and all elemenets are 0.
+ *
+ * @internal Array layout (iteration refers to one aggregate-function call):
+ * Inter-iteration components (updated in final function):
+ * - 0: iteration (current iteration)
+ * - 1: widthOfX (numer of coefficients)
+ * - 2: historySize (maximum number of correction pairs)
+ * - 3: numPairs (number of correction pairs stored)
+ * - 4: newestPair (index of the most recent correction pair)
+ * - 5: stepSize (step size of the trial point)
+ * - 6: numBacktracks (number of step-size reductions for the current
+ *      direction)
+ * - 7: logLikelihood (log-likelihood at coef)
+ * - 8: coef (vector of coefficients, last accepted point)
+ * - 8 + widthOfX: grad (gradient at coef)
+ * - 8 + 2 * widthOfX: dir (search direction)
+ * - 8 + 3 * widthOfX: trialCoef (coef + stepSize * dir)
+ * - 8 + 4 * widthOfX: S (matrix of coefficient differences, one column per
+ *   pair)
+ * - 8 + 4 * widthOfX + widthOfX * historySize: Y (matrix of gradient
+ *   differences, one column per pair)
+ * - 8 + 4 * widthOfX + 2 * widthOfX * historySize: rho (1 / s^T y for each
+ *   pair)
+ *
+ * Intra-iteration components (updated in transition step):
+ * - 8 + 4 * widthOfX + (2 * widthOfX + 1) * historySize: numRows (number of
+ *   rows already processed in this iteration)
+ * - 9 + 4 * widthOfX + (2 * widthOfX + 1) * historySize: logLikelihoodNew
+ *   (log-likelihood at trialCoef)
+ * - 10 + 4 * widthOfX + (2 * widthOfX + 1) * historySize: gradNew (gradient
+ *   at trialCoef)
+ */
+class LogisticRegressionLBFGS::State {
+public:
+    State(AnyValue inArg)
+        : mStorage(inArg.copyIfImmutable()),
+          iteration(&mStorage[0]),
+          widthOfX(&mStorage[1]),
+          historySize(&mStorage[2]),
+          numPairs(&mStorage[3]),
+          newestPair(&mStorage[4]),
+          stepSize(&mStorage[5]),
+          numBacktracks(&mStorage[6]),
+          logLikelihood(&mStorage[7]),
+          coef(TransparentHandle::create(&mStorage[8]),
+               widthOfX),
+          grad(TransparentHandle::create(&mStorage[8 + widthOfX]),
+               widthOfX),
+          dir(TransparentHandle::create(&mStorage[8 + 2 * widthOfX]),
+              widthOfX),
+          trialCoef(TransparentHandle::create(&mStorage[8 + 3 * widthOfX]),
+                    widthOfX),
+          S(TransparentHandle::create(&mStorage[8 + 4 * widthOfX]),
+            widthOfX, historySize),
+          Y(TransparentHandle::create(
+                &mStorage[8 + 4 * widthOfX + widthOfX * historySize]),
+            widthOfX, historySize),
+          rho(TransparentHandle::create(
+                &mStorage[8 + 4 * widthOfX + 2 * widthOfX * historySize]),
+              historySize),
+          
+          numRows(&mStorage[intraIterationBegin(widthOfX, historySize)]),
+          logLikelihoodNew(
+            &mStorage[intraIterationBegin(widthOfX, historySize) + 1]),
+          gradNew(TransparentHandle::create(
+                &mStorage[intraIterationBegin(widthOfX, historySize) + 2]),
+              widthOfX)
+        { }
+    
+    /**
+     * We define this function so that we can use State in the
+     * argument list and as a return type.
+     */
+    inline operator AnyValue() {
+        return mStorage;
+    }
+    
+    /**
+     * @brief Initialize the L-BFGS state.
+     * 
+     * This function is only called for the first iteration, for the first row.
+     */
+    inline void initialize(AllocatorSPtr inAllocator,
+        const uint32_t inWidthOfX, const uint16_t inHistorySize) {
+        
+        uint64_t intraBegin = intraIterationBegin(inWidthOfX, inHistorySize);
+        
+        mStorage.rebind(inAllocator,
+            boost::extents[ arraySize(inWidthOfX, inHistorySize) ]);
+        iteration.rebind(&mStorage[0]) = 0;
+        widthOfX.rebind(&mStorage[1]) = inWidthOfX;
+        historySize.rebind(&mStorage[2]) = inHistorySize;
+        numPairs.rebind(&mStorage[3]) = 0;
+        newestPair.rebind(&mStorage[4]) = 0;
+        stepSize.rebind(&mStorage[5]) = 0;
+        numBacktracks.rebind(&mStorage[6]) = 0;
+        logLikelihood.rebind(&mStorage[7]) = 0;
+        coef.rebind(TransparentHandle::create(&mStorage[8]),
+                    inWidthOfX).zeros();
+        grad.rebind(TransparentHandle::create(&mStorage[8 + inWidthOfX]),
+                    inWidthOfX).zeros();
+        dir.rebind(TransparentHandle::create(&mStorage[8 + 2 * inWidthOfX]),
+                   inWidthOfX).zeros();
+        trialCoef.rebind(
+            TransparentHandle::create(&mStorage[8 + 3 * inWidthOfX]),
+            inWidthOfX).zeros();
+        S.rebind(TransparentHandle::create(&mStorage[8 + 4 * inWidthOfX]),
+                 inWidthOfX, inHistorySize).zeros();
+        Y.rebind(TransparentHandle::create(
+                     &mStorage[8 + 4 * inWidthOfX + inWidthOfX * inHistorySize]),
+                 inWidthOfX, inHistorySize).zeros();
+        rho.rebind(TransparentHandle::create(
+                       &mStorage[8 + 4 * inWidthOfX
+                           + 2 * inWidthOfX * inHistorySize]),
+                   inHistorySize).zeros();
+
+        numRows.rebind(&mStorage[intraBegin]);
+        logLikelihoodNew.rebind(&mStorage[intraBegin + 1]);
+        gradNew.rebind(TransparentHandle::create(&mStorage[intraBegin + 2]),
+                       inWidthOfX);
+        reset();
+    }
+    
+    /**
+     * @brief We need to support assigning the previous state
+     */
+    State &operator=(const State &inOtherState) {
+        mStorage = inOtherState.mStorage;
+        return *this;
+    }
+    
+    /**
+     * @brief Merge with another State object by copying the intra-iteration fields
+     */
+    State &operator+=(const State &inOtherState) {
+        if (mStorage.size() != inOtherState.mStorage.size() ||
+            widthOfX != inOtherState.widthOfX)
+            throw std::logic_error("Internal error: Incompatible transition states");
+        
+        numRows += inOtherState.numRows;
+        logLikelihoodNew += inOtherState.logLikelihoodNew;
+        gradNew += inOtherState.gradNew;
+        return *this;
+    }
+    
+    /**
+     * @brief Reset the inter-iteration fields.
+     */
+    inline void reset() {
+        numRows = 0;
+        logLikelihoodNew = 0;
+        gradNew.zeros();
+    }
+    
+    /**
+     * @brief Add a correction pair, replacing the oldest one if the history
+     *     is full
+     *
+     * Pairs without positive curvature are skipped, so that the implicit
+     * approximation of the inverse (negative) Hessian stays positive definite.
+     */
+    inline void addCorrectionPair(const colvec &inS, const colvec &inY) {
+        double sTy = dot(inS, inY);
+        if (historySize == 0 || !(sTy > 0))
+            return;
+        
+        uint16_t next = numPairs == 0 ? 0 : (newestPair + 1) % historySize;
+        std::copy(inS.memptr(), inS.memptr() + widthOfX, S.colptr(next));
+        std::copy(inY.memptr(), inY.memptr() + widthOfX, Y.colptr(next));
+        rho(next) = 1. / sTy;
+        newestPair = next;
+        if (numPairs < historySize)
+            numPairs++;
+    }
     
-    // Merge states together and return
-    stateLeft += stateRight;
-    return stateLeft;
+    /**
+     * @brief Compute the search direction with the L-BFGS two-loop recursion
+     */
+    inline void computeDirection() {
+        colvec q = grad;
+        colvec alpha(historySize);
+        
+        for (uint16_t k = 0; k < numPairs; k++) {
+            uint16_t i = (newestPair + historySize - k) % historySize;
+            const colvec s(S.colptr(i), widthOfX, false, true);
+            const colvec y(Y.colptr(i), widthOfX, false, true);
+            alpha(i) = rho(i) * dot(s, q);
+            q -= alpha(i) * y;
+        }
+        
+        // Initial approximation: gamma * I with gamma = s^T y / y^T y of the
+        // newest pair
+        if (numPairs > 0) {
+            const colvec y(Y.colptr(newestPair), widthOfX, false, true);
+            q *= 1. / (rho(newestPair) * dot(y, y));
+        }
+        
+        for (uint16_t k = numPairs; k > 0; k--) {
+            uint16_t i = (newestPair + historySize - (k - 1)) % historySize;
+            const colvec s(S.colptr(i), widthOfX, false, true);
+            const colvec y(Y.colptr(i), widthOfX, false, true);
+            double beta = rho(i) * dot(y, q);
+            q += (alpha(i) - beta) * s;
+        }
+        dir = q;
+    }
+
+private:
+    static inline uint64_t intraIterationBegin(const uint32_t inWidthOfX,
+        const uint16_t inHistorySize) {
+        
+        const uint64_t widthOfX = inWidthOfX;
+        return 8 + 4 * widthOfX + (2 * widthOfX + 1) * inHistorySize;
+    }
+
+    static inline uint64_t arraySize(const uint32_t inWidthOfX,
+        const uint16_t inHistorySize) {
+        
+        return intraIterationBegin(inWidthOfX, inHistorySize) + 2 + inWidthOfX;
+    }
+
+    Array<double> mStorage;
+
+public:
+    Reference<double, uint32_t> iteration;
+    Reference<double, uint32_t> widthOfX;
+    Reference<double, uint16_t> historySize;
+    Reference<double, uint16_t> numPairs;
+    Reference<double, uint16_t> newestPair;
+    Reference<double> stepSize;
+    Reference<double, uint16_t> numBacktracks;
+    Reference<double> logLikelihood;
+    DoubleCol coef;
+    DoubleCol grad;
+    DoubleCol dir;
+    DoubleCol trialCoef;
+    DoubleMat S;
+    DoubleMat Y;
+    DoubleCol rho;
+    
+    Reference<double, uint64_t> numRows;
+    Reference<double> logLikelihoodNew;
+    DoubleCol gradNew;
+};
+
+/**
+ * @brief Perform the L-BFGS transition step
+ *
+ * An optional fifth argument specifies the number of correction pairs to keep
+ * (default 10). It is only read for the first row of the first iteration.
+ */
+AnyValue LogisticRegressionLBFGS::transition(AbstractDBInterface &db,
+    AnyValue args) {
+    
+    AnyValue::iterator arg(args);
+    
+    // Initialize Arguments from SQL call
+    State state = *arg++;
+    double y = arg++.getAs<bool>() ? 1. : -1.;
+    DoubleRow_const x = arg++.getAs<DoubleRow_const>();
+    
+    return transitionStep(db, state, y, x, arg, args.size() - 4);
+}
+
+/**
+ * @brief Perform the L-BFGS transition step for a single-precision row
+ *
+ * The arguments are as for transition(), except that the independent
+ * variables are of type REAL[].
+ */
+AnyValue LogisticRegressionLBFGS::floatTransition(AbstractDBInterface &db,
+    AnyValue args) {
+    
+    AnyValue::iterator arg(args);
+    
+    State state = *arg++;
+    double y = arg++.getAs<bool>() ? 1. : -1.;
+    FloatRow_const x = arg++.getAs<Array_const<float> >();
+    
+    return transitionStep(db, state, y, x, arg, args.size() - 4);
+}
+
+/**
+ * @brief Perform the L-BFGS transition step for a sparse row
+ *
+ * The independent variables are given by their one-based positions, their
+ * values, and their number. Otherwise, the arguments are as for transition().
+ */
+AnyValue LogisticRegressionLBFGS::sparseTransition(AbstractDBInterface &db,
+    AnyValue args) {
+    
+    AnyValue::iterator arg(args);
+    
+    State state = *arg++;
+    double y = arg++.getAs<bool>() ? 1. : -1.;
+    SparseVector_const x = sparseRowArg(arg);
+    
+    return transitionStep(db, state, y, x, arg, args.size() - 6);
+}
+
+/**
+ * @brief Transition step common to dense and sparse rows
+ *
+ * @param arg Iterator pointing to the previous state
+ * @param inNumOptionalArgs Number of arguments after the previous state
+ */
+template <class Row>
+AnyValue LogisticRegressionLBFGS::transitionStep(AbstractDBInterface &db,
+    State &state, const double y, const Row &x, AnyValue::iterator &arg,
+    const unsigned int inNumOptionalArgs) {
+    
+    if (state.numRows == 0) {
+        const AnyValue previousStateArg = *arg++;
+        
+        if (previousStateArg.isNull()) {
+            int32_t historySize = 10;
+            if (inNumOptionalArgs > 0 && !arg->isNull())
+                historySize = arg.getAs<int32_t>();
+            if (historySize < 1 || historySize > 1000)
+                throw std::invalid_argument("Number of correction pairs must "
+                    "be between 1 and 1000");
+            
+            state.initialize(db.allocator(AbstractAllocator::kAggregate),
+                x.n_elem, historySize);
+        } else {
+            const State previousState = previousStateArg;
+            
+            state.initialize(db.allocator(AbstractAllocator::kAggregate),
+                previousState.widthOfX, previousState.historySize);
+            state = previousState;
+            state.reset();
+        }
+    }
+    if (x.n_elem != state.widthOfX)
+        throw std::invalid_argument("Inconsistent numbers of independent variables");
+    
+    // Now do the transition step
+    state.numRows++;
+    
+    double xc = rowDot(x, state.trialCoef);
+    double sigmaYXc, sigmaNegYXc;
+    state.logLikelihoodNew += logisticTerms(y * xc, sigmaYXc, sigmaNegYXc);
+    addScaledRow(state.gradNew, sigmaNegYXc * y, x);
+    return state;
+}
+
+/**
+ * @brief Perform the perliminary aggregation function: Merge transition states
+ */
+AnyValue LogisticRegressionLBFGS::preliminary(AbstractDBInterface &db,
+    AnyValue args) {
+    return mergeStates<State>(args);
+}
+
+/**
+ * @brief Perform the L-BFGS final step
+ *
+ * We maximize the log-likelihood. A trial point is accepted if it satisfies
+ * the Armijo condition
+ * \f$ l(c + t d) \geq l(c) + 10^{-4} \cdot t \cdot g^T d \f$.
+ * Otherwise, the step size is reduced by maximizing the quadratic
+ * interpolation of \f$ l(c + t d) \f$ (restricted to between 1/10 and 1/2 of
+ * the previous step size), and the next iteration evaluates the new trial
+ * point.
+ */
+AnyValue LogisticRegressionLBFGS::final(AbstractDBInterface &db,
+    AnyValue args) {
+    
+    // Argument from SQL call
+    State state = args[0].copyIfImmutable();
+    
+    const double kArmijo = 1e-4;
+    const double t = state.stepSize;
+    const double dirDerivative = dot(state.grad, state.dir);
+    
+    bool accept = state.iteration == 0
+        || state.logLikelihoodNew
+            >= state.logLikelihood + kArmijo * t * dirDerivative;
+    
+    if (!accept) {
+        // Maximum of the quadratic through l(c), l'(c) and l(c + t d)
+        double curvature = state.logLikelihoodNew - state.logLikelihood
+            - dirDerivative * t;
+        double tNew = curvature < 0 && std::isfinite(curvature)
+            ? -dirDerivative * t * t / (2. * curvature)
+            : 0.5 * t;
+        tNew = std::max(0.1 * t, std::min(0.5 * t, tNew));
+        
+        state.stepSize = tNew;
+        state.trialCoef = state.coef + tNew * state.dir;
+        state.numBacktracks++;
+        state.iteration++;
+        return state;
+    }
+    
+    if (state.iteration > 0) {
+        // Gradient of the negative log-likelihood: y_k = -(g_{k+1} - g_k)
+        colvec s = state.trialCoef - state.coef;
+        colvec y = state.grad - state.gradNew;
+        state.addCorrectionPair(s, y);
+    }
+    state.coef = state.trialCoef;
+    state.grad = state.gradNew;
+    state.logLikelihood = state.logLikelihoodNew;
+    state.numBacktracks = 0;
+    
+    state.computeDirection();
+    if (!(dot(state.grad, state.dir) > 0)) {
+        // Not an ascent direction: Forget the history
+        state.numPairs = 0;
+        state.dir = state.grad;
+    }
+    
+    // Without history, the direction is not scaled yet
+    double gradNorm = std::sqrt(dot(state.grad, state.grad));
+    state.stepSize = state.numPairs > 0 || gradNorm <= 1.
+        ? 1.
+        : 1. / gradNorm;
+    state.trialCoef = state.coef + state.stepSize * state.dir;
+    state.iteration++;
+    return state;
+}
+
+/**
+ * @brief Return the difference in log-likelihood between two states
+ *
+ * While backtracking, the log-likelihood of the accepted coefficients does not
+ * change. The distance is infinite in that case.
+ */
+AnyValue LogisticRegressionLBFGS::distance(AbstractDBInterface &db,
+    AnyValue args) {
+    
+    const State stateLeft = args[0];
+    const State stateRight = args[1];
+
+    if (stateLeft.numBacktracks > 0 || stateRight.numBacktracks > 0)
+        return std::numeric_limits<double>::infinity();
+    return std::abs(stateLeft.logLikelihood - stateRight.logLikelihood);
+}
+
+/**
+ * @brief Return the coefficients of the state
+ */
+AnyValue LogisticRegressionLBFGS::coef(AbstractDBInterface &db,
+    AnyValue args) {
+    
+    const State state = args[0];
+
+    return state.coef;
+}
+
+/**
+ * @brief Turn the final state of an earlier run into the initial state of a
+ *        new run (warm start)
+ *
+ * The first iteration of the new run evaluates the trial point, which is
+ * accepted without the Armijo test. We therefore set it to the accepted
+ * coefficients. The correction pairs are kept, since the curvature changes
+ * little if the data only changes slightly.
+ */
+AnyValue LogisticRegressionLBFGS::warmStart(AbstractDBInterface &db,
+    AnyValue args) {
+    
+    State state = args[0].copyIfImmutable();
+    
+    state.iteration = 0;
+    state.numBacktracks = 0;
+    state.trialCoef = state.coef;
+    state.reset();
+    return state;
+}
+
+/**
+ * @brief Inter- and intra-iteration state for stochastic gradient descent for
+ *        logistic regression
+ *
+ * Each iteration (one aggregate-function call) is one pass (epoch) over the
+ * data. The transition function updates the model after every row. On
+ * Greenplum, each segment trains its own model, starting from the
+ * coefficients of the previous epoch, and the preliminary function averages
+ * the models weighted by their numbers of rows.
+ *
+ * The step size for the t-th row (counted over all epochs) is
+ * \f$ \eta_t = \eta_0 / (1 + \lambda t) \f$, where \f$ \eta_0 \f$ is stepSize
+ * and \f$ \lambda \f$ is stepDecay. If stepDecay is 0, the step size is
+ * constant. Within an epoch, t is the number of rows in all previous epochs
+ * plus the number of rows that the current segment has seen so far.
+ *
+ * Note: We assume that the DOUBLE PRECISION array is initialized by the
+ * database with length at least 8, and all elemenets are 0.
+ *
+ * @internal Array layout (iteration refers to one aggregate-function call):
+ * Inter-iteration components (updated in final function):
+ * - 0: iteration (current iteration)
+ * - 1: widthOfX (numer of coefficients)
+ * - 2: stepSize (initial step size)
+ * - 3: stepDecay (decay of the step size)
+ * - 4: numPreviousRows (number of rows processed in all previous iterations)
+ * - 5: coef (vector of coefficients, average model of the previous
+ *      iteration)
+ *
+ * Intra-iteration components (updated in transition step):
+ * - 5 + widthOfX: numRows (number of rows already processed in this iteration)
+ * - 6 + widthOfX: logLikelihood (sum of the log-likelihood terms of each row,
+ *   evaluated before the model is updated with that row)
+ * - 7 + widthOfX: model (vector of coefficients, updated after every row)
+ */
+class LogisticRegressionSGD::State {
+public:
+    State(AnyValue inArg)
+        : mStorage(inArg.copyIfImmutable()),
+          iteration(&mStorage[0]),
+          widthOfX(&mStorage[1]),
+          stepSize(&mStorage[2]),
+          stepDecay(&mStorage[3]),
+          numPreviousRows(&mStorage[4]),
+          coef(TransparentHandle::create(&mStorage[5]),
+               widthOfX),
+          
+          numRows(&mStorage[5 + widthOfX]),
+          logLikelihood(&mStorage[6 + widthOfX]),
+          model(TransparentHandle::create(&mStorage[7 + widthOfX]),
+                widthOfX)
+        { }
+    
+    /**
+     * We define this function so that we can use State in the
+     * argument list and as a return type.
+     */
+    inline operator AnyValue() {
+        return mStorage;
+    }
+    
+    /**
+     * @brief Initialize the stochastic-gradient-descent state.
+     * 
+     * This function is only called for the first iteration, for the first row.
+     */
+    inline void initialize(AllocatorSPtr inAllocator,
+        const uint32_t inWidthOfX) {
+        
+        mStorage.rebind(inAllocator, boost::extents[ arraySize(inWidthOfX) ]);
+        iteration.rebind(&mStorage[0]) = 0;
+        widthOfX.rebind(&mStorage[1]) = inWidthOfX;
+        stepSize.rebind(&mStorage[2]) = 0;
+        stepDecay.rebind(&mStorage[3]) = 0;
+        numPreviousRows.rebind(&mStorage[4]) = 0;
+        coef.rebind(TransparentHandle::create(&mStorage[5]),
+                    inWidthOfX).zeros();
+        
+        numRows.rebind(&mStorage[5 + inWidthOfX]);
+        logLikelihood.rebind(&mStorage[6 + inWidthOfX]);
+        model.rebind(TransparentHandle::create(&mStorage[7 + inWidthOfX]),
+                     inWidthOfX);
+        reset();
+    }
+    
+    /**
+     * @brief We need to support assigning the previous state
+     */
+    State &operator=(const State &inOtherState) {
+        mStorage = inOtherState.mStorage;
+        return *this;
+    }
+    
+    /**
+     * @brief Merge with another State object by averaging the models
+     *
+     * The models are weighted by the number of rows they were trained on.
+     */
+    State &operator+=(const State &inOtherState) {
+        if (mStorage.size() != inOtherState.mStorage.size() ||
+            widthOfX != inOtherState.widthOfX)
+            throw std::logic_error("Internal error: Incompatible transition states");
+        
+        uint64_t totalNumRows = numRows + inOtherState.numRows;
+        if (totalNumRows > 0) {
+            double weight = static_cast<double>(inOtherState.numRows)
+                / totalNumRows;
+            model += weight * (inOtherState.model - model);
+        }
+        numRows = totalNumRows;
+        logLikelihood += inOtherState.logLikelihood;
+        return *this;
+    }
+    
+    /**
+     * @brief Reset the inter-iteration fields.
+     *
+     * Each iteration starts with the average model of the previous one.
+     */
+    inline void reset() {
+        numRows = 0;
+        logLikelihood = 0;
+        model = coef;
+    }
+    
+private:
+    static inline uint64_t arraySize(const uint32_t inWidthOfX) {
+        return 7 + 2 * static_cast<uint64_t>(inWidthOfX);
+    }
+
+    Array<double> mStorage;
+
+public:
+    Reference<double, uint32_t> iteration;
+    Reference<double, uint32_t> widthOfX;
+    Reference<double> stepSize;
+    Reference<double> stepDecay;
+    Reference<double, uint64_t> numPreviousRows;
+    DoubleCol coef;
+    
+    Reference<double, uint64_t> numRows;
+    Reference<double> logLikelihood;
+    DoubleCol model;
+};
+
+/**
+ * @brief Perform the stochastic-gradient-descent transition step
+ *
+ * Optional fifth and sixth arguments specify the initial step size (default
+ * 0.1) and its decay (default 0.001). They are only read for the first row of
+ * the first iteration.
+ */
+AnyValue LogisticRegressionSGD::transition(AbstractDBInterface &db,
+    AnyValue args) {
+    
+    AnyValue::iterator arg(args);
+    
+    // Initialize Arguments from SQL call
+    State state = *arg++;
+    double y = arg++.getAs<bool>() ? 1. : -1.;
+    DoubleRow_const x = arg++.getAs<DoubleRow_const>();
+    
+    return transitionStep(db, state, y, x, arg, args.size() - 4);
+}
+
+/**
+ * @brief Perform the stochastic-gradient-descent transition step for a single-precision row
+ *
+ * The arguments are as for transition(), except that the independent
+ * variables are of type REAL[].
+ */
+AnyValue LogisticRegressionSGD::floatTransition(AbstractDBInterface &db,
+    AnyValue args) {
+    
+    AnyValue::iterator arg(args);
+    
+    State state = *arg++;
+    double y = arg++.getAs<bool>() ? 1. : -1.;
+    FloatRow_const x = arg++.getAs<Array_const<float> >();
+    
+    return transitionStep(db, state, y, x, arg, args.size() - 4);
+}
+
+/**
+ * @brief Perform the stochastic-gradient-descent transition step for a sparse row
+ *
+ * The independent variables are given by their one-based positions, their
+ * values, and their number. Otherwise, the arguments are as for transition().
+ */
+AnyValue LogisticRegressionSGD::sparseTransition(AbstractDBInterface &db,
+    AnyValue args) {
+    
+    AnyValue::iterator arg(args);
+    
+    State state = *arg++;
+    double y = arg++.getAs<bool>() ? 1. : -1.;
+    SparseVector_const x = sparseRowArg(arg);
+    
+    return transitionStep(db, state, y, x, arg, args.size() - 6);
+}
+
+/**
+ * @brief Transition step common to dense and sparse rows
+ *
+ * @param arg Iterator pointing to the previous state
+ * @param inNumOptionalArgs Number of arguments after the previous state
+ */
+template <class Row>
+AnyValue LogisticRegressionSGD::transitionStep(AbstractDBInterface &db,
+    State &state, const double y, const Row &x, AnyValue::iterator &arg,
+    const unsigned int inNumOptionalArgs) {
+    
+    if (state.numRows == 0) {
+        const AnyValue previousStateArg = *arg++;
+        
+        if (previousStateArg.isNull()) {
+            state.initialize(db.allocator(AbstractAllocator::kAggregate),
+                x.n_elem);
+            
+            double stepSize = 0.1;
+            double stepDecay = 0.001;
+            if (inNumOptionalArgs > 0 && !arg->isNull())
+                stepSize = arg.getAs<double>();
+            ++arg;
+            if (inNumOptionalArgs > 1 && !arg->isNull())
+                stepDecay = arg.getAs<double>();
+            if (!(stepSize > 0))
+                throw std::invalid_argument("Step size must be positive");
+            if (!(stepDecay >= 0))
+                throw std::invalid_argument("Decay of step size must not be "
+                    "negative");
+            
+            state.stepSize = stepSize;
+            state.stepDecay = stepDecay;
+        } else {
+            const State previousState = previousStateArg;
+            
+            state.initialize(db.allocator(AbstractAllocator::kAggregate),
+                previousState.widthOfX);
+            state = previousState;
+            state.reset();
+        }
+    }
+    if (x.n_elem != state.widthOfX)
+        throw std::invalid_argument("Inconsistent numbers of independent variables");
+    
+    // Now do the transition step
+    double t = static_cast<double>(state.numPreviousRows + state.numRows);
+    double eta = state.stepSize / (1. + state.stepDecay * t);
+    state.numRows++;
+    
+    double xc = rowDot(x, state.model);
+    double sigmaYXc, sigmaNegYXc;
+    state.logLikelihood += logisticTerms(y * xc, sigmaYXc, sigmaNegYXc);
+    
+    // Gradient ascent along the gradient of ln sigma(y_i x_i c)
+    addScaledRow(state.model, eta * sigmaNegYXc * y, x);
+    return state;
+}
+
+/**
+ * @brief Perform the perliminary aggregation function: Merge transition states
+ */
+AnyValue LogisticRegressionSGD::preliminary(AbstractDBInterface &db,
+    AnyValue args) {
+    return mergeStates<State>(args);
+}
+
+/**
+ * @brief Perform the stochastic-gradient-descent final step
+ */
+AnyValue LogisticRegressionSGD::final(AbstractDBInterface &db,
+    AnyValue args) {
+    
+    // Argument from SQL call
+    State state = args[0].copyIfImmutable();
+    
+    state.coef = state.model;
+    state.numPreviousRows += state.numRows;
+    state.iteration++;
+    return state;
+}
+
+/**
+ * @brief Return the difference in log-likelihood between two states
+ *
+ * The log-likelihood of an iteration is accumulated while the model changes,
+ * so this is only an estimate of the change in the objective function.
+ */
+AnyValue LogisticRegressionSGD::distance(AbstractDBInterface &db,
+    AnyValue args) {
+    
+    const State stateLeft = args[0];
+    const State stateRight = args[1];
+
+    return std::abs(stateLeft.logLikelihood - stateRight.logLikelihood);
+}
+
+/**
+ * @brief Return the coefficients of the state
+ */
+AnyValue LogisticRegressionSGD::coef(AbstractDBInterface &db,
+    AnyValue args) {
+    
+    const State state = args[0];
+
+    return state.coef;
+}
+
+/**
+ * @brief Inter- and intra-iteration state for iteratively-reweighted-least-
+ *        squares method for logistic regression
+ *
+ * TransitionState encapsualtes the transition state during the
+ * logistic-regression aggregate function. To the database, the state is
+ * exposed as a single DOUBLE PRECISION array, to the C++ code it is a proper
+ * object containing scalars, a vector, and a matrix.
+ *
+ * Note: We assume that the DOUBLE PRECISION array is initialized by the
+ * database with length at least 7, and all elemenets are 0.
+ *
+ * The first element is the version of the array layout, which is 0 only for
+ * the initial value. States with a different layout are rejected.
+ *
+ * If batchSize is greater than 1, rows are first collected in yBlock and
+ * XBlock (one column per row). Every batchSize rows, the weights are computed
+ * for the whole block, which is then added to X^T A X with a single rank-k
+ * update. Functions that read the intra-iteration components have to call
+ * flush() first.
+ *
+ * @internal Array layout (iteration refers to one aggregate-function call):
+ * Inter-iteration components (updated in final function):
+ * - 0: layoutVersion (kLayoutVersion, or 0 if not yet initialized)
+ * - 1: widthOfX (numer of coefficients)
+ * - 2: batchSize (number of rows to buffer, 0 disables buffering)
+ * - 3: coef (vector of coefficients)
+ *
+ * Intra-iteration components (updated in transition step):
+ * - 3 + widthOfX: numRows (number of rows already processed in this iteration)
+ * - 4 + widthOfX: numBuffered (number of rows currently buffered)
+ * - 5 + widthOfX: logLikelihood ( ln(l(c)) )
+ * - 6 + widthOfX: yBlock (buffered values of the dependent variable)
+ * - 6 + widthOfX + batchSize: XBlock (buffered independent variables)
+ * - 6 + widthOfX + (widthOfX + 1) * batchSize: X_transp_Az (X^T A z)
+ * - 6 + 2 * widthOfX + (widthOfX + 1) * batchSize: X_transp_AX (X^T A X, in
+ *   packed storage, see packedSize())
+ */
+class LogisticRegressionIRLS::State {
+public:
+    enum { kLayoutVersion = 1 };
+    
+    State(AnyValue inArg)
+        : mStorage(inArg.copyIfImmutable()),
+          layoutVersion(&mStorage[0]),
+          widthOfX(&mStorage[1]),
+          batchSize(&mStorage[2]),
+          coef(TransparentHandle::create(&mStorage[3]),
+               widthOfX),
+        
+          numRows(&mStorage[3 + widthOfX]),
+          numBuffered(&mStorage[4 + widthOfX]),
+          logLikelihood(&mStorage[5 + widthOfX]),
+          yBlock(TransparentHandle::create(&mStorage[6 + widthOfX]),
+              batchSize),
+          XBlock(TransparentHandle::create(&mStorage[6 + widthOfX + batchSize]),
+              widthOfX, batchSize),
+          X_transp_Az(TransparentHandle::create(
+                &mStorage[accumulatorsBegin(widthOfX, batchSize)]),
+              widthOfX),
+          X_transp_AX(TransparentHandle::create(
+                &mStorage[accumulatorsBegin(widthOfX, batchSize) + widthOfX]),
+              packedSize(widthOfX)) {
+        
+        if (layoutVersion != 0 && layoutVersion != kLayoutVersion)
+            throw std::invalid_argument("Transition state has an unsupported "
+                "layout version");
+    }
+    
+    /**
+     * We define this function so that we can use State in the
+     * argument list and as a return type.
+     */
+    inline operator AnyValue() {
+        return mStorage;
+    }
+    
+    /**
+     * @brief Initialize the conjugate-gradient state.
+     * 
+     * This function is only called for the first iteration, for the first row.
+     */
+    inline void initialize(AllocatorSPtr inAllocator,
+        const uint16_t inWidthOfX, const uint16_t inBatchSize = 0) {
+        
+        uint64_t accBegin = accumulatorsBegin(inWidthOfX, inBatchSize);
+        uint64_t size = arraySize(inWidthOfX, inBatchSize);
+        if (size > std::numeric_limits<uint32_t>::max())
+            throw std::invalid_argument("Transition state would be too large");
+        
+        mStorage.rebind(inAllocator, boost::extents[ size ]);
+        layoutVersion.rebind(&mStorage[0]) = kLayoutVersion;
+        widthOfX.rebind(&mStorage[1]) = inWidthOfX;
+        batchSize.rebind(&mStorage[2]) = inBatchSize;
+        coef.rebind(TransparentHandle::create(&mStorage[3]),
+                    widthOfX).zeros();
+        
+        numRows.rebind(&mStorage[3 + widthOfX]);
+        numBuffered.rebind(&mStorage[4 + widthOfX]);
+        logLikelihood.rebind(&mStorage[5 + widthOfX]);
+        yBlock.rebind(TransparentHandle::create(&mStorage[6 + widthOfX]),
+                      inBatchSize);
+        XBlock.rebind(TransparentHandle::create(
+                          &mStorage[6 + widthOfX + inBatchSize]),
+                      inWidthOfX, inBatchSize);
+        X_transp_Az.rebind(TransparentHandle::create(&mStorage[accBegin]),
+                           widthOfX);
+        X_transp_AX.rebind(TransparentHandle::create(
+                               &mStorage[accBegin + widthOfX]),
+                           packedSize(widthOfX));
+        reset();
+    }
+    
+    /**
+     * @brief We need to support assigning the previous state
+     */
+    State &operator=(const State &inOtherState) {
+        mStorage = inOtherState.mStorage;
+        return *this;
+    }
+    
+    /**
+     * @brief Add a row to the intra-iteration fields, either directly or via
+     *     the buffer
+     *
+     * The caller is responsible for updating numRows.
+     * The elements of \c inX are either of type double or float.
+     */
+    template <typename T>
+    inline void addRow(const double inY, const T *inX) {
+        if (batchSize <= 1) {
+            double xc = 0;
+            for (uint16_t i = 0; i < widthOfX; i++)
+                xc += inX[i] * coef(i);
+            
+            double sigmaYXc, sigmaNegYXc;
+            logLikelihood += logisticTerms(inY * xc, sigmaYXc, sigmaNegYXc);
+            
+            double a, az;
+            rowTerms(inY, xc, sigmaYXc, sigmaNegYXc, a, az);
+            for (uint16_t i = 0; i < widthOfX; i++)
+                X_transp_Az(i) += inX[i] * az;
+            packedRankOneUpdate(X_transp_AX.memptr(), widthOfX, inX, a);
+            return;
+        }
+        
+        yBlock(numBuffered) = inY;
+        std::copy(inX, inX + widthOfX, XBlock.colptr(numBuffered));
+        numBuffered++;
+        if (numBuffered == batchSize)
+            flush();
+    }
+    
+    /**
+     * @brief Add a sparse row to the intra-iteration fields
+     *
+     * Without buffering, only the elements that belong to non-zero
+     * independent variables are updated. With buffering, the row is expanded
+     * into the buffer.
+     */
+    inline void addRow(const double inY, const SparseVector_const &inX) {
+        if (batchSize <= 1) {
+            double xc = inX.dot(coef.memptr());
+            
+            double sigmaYXc, sigmaNegYXc;
+            logLikelihood += logisticTerms(inY * xc, sigmaYXc, sigmaNegYXc);
+            
+            double a, az;
+            rowTerms(inY, xc, sigmaYXc, sigmaNegYXc, a, az);
+            inX.addTo(X_transp_Az.memptr(), az);
+            packedRankOneUpdate(X_transp_AX.memptr(), widthOfX, inX, a);
+            return;
+        }
+        
+        yBlock(numBuffered) = inY;
+        inX.toDense(XBlock.colptr(numBuffered));
+        numBuffered++;
+        if (numBuffered == batchSize)
+            flush();
+    }
+    
+    /**
+     * @brief Add all buffered rows to the intra-iteration fields
+     *
+     * The buffer is used as scratch space: Column i of XBlock is scaled by
+     * sqrt(a_i), and yBlock(i) is overwritten with sqrt(a_i) z_i. Then
+     * X^T A X and X^T A z are the product of the scaled block with its own
+     * transpose and with the overwritten yBlock, respectively. The logistic
+     * terms of all buffered rows are computed with one call of
+     * logisticTermsBlock().
+     *
+     * If a_i underflows to 0, row i still contributes a_i z_i to X^T A z. We
+     * add it directly and clear the row in the buffer.
+     */
+    inline void flush() {
+        if (numBuffered == 0)
+            return;
+        
+        mat X(XBlock.memptr(), widthOfX, numBuffered,
+            false /* copy_aux_mem */, true /* strict */);
+        colvec sqrtAz(yBlock.memptr(), numBuffered,
+            false /* copy_aux_mem */, true /* strict */);
+        colvec Xc = trans(X) * coef;
+        
+        colvec margins(numBuffered);
+        colvec sigmaYXc(numBuffered);
+        colvec sigmaNegYXc(numBuffered);
+        for (uint16_t j = 0; j < numBuffered; j++)
+            margins(j) = sqrtAz(j) * Xc(j);
+        logLikelihood += logisticTermsBlock(margins.memptr(),
+            sigmaYXc.memptr(), sigmaNegYXc.memptr(), numBuffered);
+        
+        for (uint16_t j = 0; j < numBuffered; j++) {
+            double a, az;
+            rowTerms(sqrtAz(j), Xc(j), sigmaYXc(j), sigmaNegYXc(j), a, az);
+            
+            double *xj = X.colptr(j);
+            if (!(a > 0)) {
+                for (uint16_t i = 0; i < widthOfX; i++) {
+                    X_transp_Az(i) += xj[i] * az;
+                    xj[i] = 0;
+                }
+                sqrtAz(j) = 0;
+                continue;
+            }
+            
+            double sqrtA = std::sqrt(a);
+            for (uint16_t i = 0; i < widthOfX; i++)
+                xj[i] *= sqrtA;
+            sqrtAz(j) = az / sqrtA;
+        }
+        
+        X_transp_Az += X * sqrtAz;
+        packedRankKUpdate(X_transp_AX.memptr(), widthOfX, X.memptr(),
+            numBuffered);
+        numBuffered = 0;
+    }
+    
+    /**
+     * @brief Merge with another State object by copying the intra-iteration fields
+     *
+     * Rows buffered in the other state are added to this state one by one.
+     */
+    State &operator+=(const State &inOtherState) {
+        if (mStorage.size() != inOtherState.mStorage.size() ||
+            widthOfX != inOtherState.widthOfX ||
+            batchSize != inOtherState.batchSize)
+            throw std::logic_error("Internal error: Incompatible transition states");
+        
+        // X_transp_Az and X_transp_AX are adjacent in the array
+        numRows += inOtherState.numRows;
+        addRange(mStorage, inOtherState.mStorage,
+            accumulatorsBegin(widthOfX, batchSize),
+            widthOfX + packedSize(widthOfX));
+        logLikelihood += inOtherState.logLikelihood;
+        
+        for (uint16_t i = 0; i < inOtherState.numBuffered; i++)
+            addRow(inOtherState.yBlock(i), inOtherState.XBlock.colptr(i));
+        return *this;
+    }
+    
+    /**
+     * @brief Reset the inter-iteration fields.
+     */
+    inline void reset() {
+        numRows = 0;
+        numBuffered = 0;
+        X_transp_Az.zeros();
+        X_transp_AX.zeros();
+        logLikelihood = 0;
+    }
+    
+private:
+    /**
+     * @brief Compute weight and weighted adjusted response of a row
+     *
+     * The caller adds the log-likelihood term that logisticTerms() returns.
+     * We return a_i z_i instead of z_i, because z_i is infinite if a_i
+     * underflows.
+     */
+    static inline void rowTerms(const double inY, const double inXc,
+        const double inSigmaYXc, const double inSigmaNegYXc,
+        double &outA, double &outAz) {
+        
+        // a_i = sigma(x_i c) sigma(-x_i c) = sigma(y_i x_i c) sigma(-y_i x_i c)
+        outA = inSigmaYXc * inSigmaNegYXc;
+        
+        // Note: sigma(-x) = 1 - sigma(x).
+        //
+        //             sigma(-y_i x_i c) y_i
+        // z = x_i c + ---------------------
+        //                     a_i
+        outAz = outA * inXc + inSigmaNegYXc * inY;
+    }
+    
+    static inline uint64_t accumulatorsBegin(const uint16_t inWidthOfX,
+        const uint16_t inBatchSize) {
+        
+        return 6 + inWidthOfX
+            + (static_cast<uint64_t>(inWidthOfX) + 1) * inBatchSize;
+    }
+    
+    static inline uint64_t arraySize(const uint16_t inWidthOfX,
+        const uint16_t inBatchSize) {
+        
+        return accumulatorsBegin(inWidthOfX, inBatchSize)
+            + inWidthOfX + packedSize(inWidthOfX);
+    }
+
+    Array<double> mStorage;
+
+public:
+    Reference<double, uint16_t> layoutVersion;
+    Reference<double, uint16_t> widthOfX;
+    Reference<double, uint16_t> batchSize;
+    DoubleCol coef;
+
+    Reference<double, uint64_t> numRows;
+    Reference<double, uint16_t> numBuffered;
+    Reference<double> logLikelihood;
+    DoubleCol yBlock;
+    DoubleMat XBlock;
+    DoubleCol X_transp_Az;
+    DoubleCol X_transp_AX;
+};
+
+/**
+ * @brief Perform the IRLS transition step
+ *
+ * An optional fifth argument specifies the number of rows that are buffered
+ * before they are added to the state in one block. It is only read for the
+ * first row of each iteration.
+ */
+AnyValue LogisticRegressionIRLS::transition(AbstractDBInterface &db,
+    AnyValue args) {
+    AnyValue::iterator arg(args);
+    
+    // Initialize Arguments from SQL call
+    State state = *arg++;
+    double y = arg++.getAs<bool>() ? 1. : -1.;
+    DoubleRow_const x = arg++.getAs<DoubleRow_const>();
+    
+    return transitionStep(db, state, y, x, arg, args.size() - 4);
+}
+
+/**
+ * @brief Perform the IRLS transition step for a single-precision row
+ *
+ * The arguments are as for transition(), except that the independent
+ * variables are of type REAL[].
+ */
+AnyValue LogisticRegressionIRLS::floatTransition(AbstractDBInterface &db,
+    AnyValue args) {
+    
+    AnyValue::iterator arg(args);
+    
+    State state = *arg++;
+    double y = arg++.getAs<bool>() ? 1. : -1.;
+    FloatRow_const x = arg++.getAs<Array_const<float> >();
+    
+    return transitionStep(db, state, y, x, arg, args.size() - 4);
+}
+
+/**
+ * @brief Perform the IRLS transition step for a sparse row
+ *
+ * The independent variables are given by their one-based positions, their
+ * values, and their number. Otherwise, the arguments are as for transition().
+ */
+AnyValue LogisticRegressionIRLS::sparseTransition(AbstractDBInterface &db,
+    AnyValue args) {
+    
+    AnyValue::iterator arg(args);
+    
+    State state = *arg++;
+    double y = arg++.getAs<bool>() ? 1. : -1.;
+    SparseVector_const x = sparseRowArg(arg);
+    
+    return transitionStep(db, state, y, x, arg, args.size() - 6);
+}
+
+/**
+ * @brief Transition step common to dense and sparse rows
+ *
+ * @param arg Iterator pointing to the previous state
+ * @param inNumOptionalArgs Number of arguments after the previous state
+ */
+template <class Row>
+AnyValue LogisticRegressionIRLS::transitionStep(AbstractDBInterface &db,
+    State &state, const double y, const Row &x, AnyValue::iterator &arg,
+    const unsigned int inNumOptionalArgs) {
+    
+    if (state.numRows == 0) {
+        if (x.n_elem > std::numeric_limits<uint16_t>::max())
+            throw std::invalid_argument("Number of independent variables "
+                "cannot be larger than 65535");
+        
+        const AnyValue previousStateArg = *arg++;
+        
+        int32_t batchSize = 0;
+        if (inNumOptionalArgs > 0 && !arg->isNull())
+            batchSize = arg.getAs<int32_t>();
+        if (batchSize < 0 || batchSize > std::numeric_limits<uint16_t>::max())
+            throw std::invalid_argument("Batch size must be between 0 and 65535");
+        
+        if (previousStateArg.isNull()) {
+            state.initialize(db.allocator(AbstractAllocator::kAggregate),
+                x.n_elem, batchSize);
+        } else {
+            const State previousState = previousStateArg;
+            
+            // The only inter-iteration component is coef, so the batch size
+            // may differ from the one of the previous state
+            state.initialize(db.allocator(AbstractAllocator::kAggregate),
+                previousState.widthOfX, batchSize);
+            state.coef = previousState.coef;
+        }
+    }
+    if (x.n_elem != state.widthOfX)
+        throw std::invalid_argument("Inconsistent numbers of independent variables");
+    
+    // Now do the transition step
+    state.numRows++;
+    state.addRow(y, rowElements(x));
+    return state;
+}
+
+/**
+ * @brief Perform the perliminary aggregation function: Merge transition states
+ */
+AnyValue LogisticRegressionIRLS::preliminary(AbstractDBInterface &db, AnyValue args) {
+    return mergeStates<State>(args);
 }
 
 /**
@@ -470,10 +1910,13 @@ AnyValue LogisticRegressionIRLS::preliminary(AbstractDBInterface &db, AnyValue a
 AnyValue LogisticRegressionIRLS::final(AbstractDBInterface &db, AnyValue args) {
     // Argument from SQL call
     State state = args[0].copyIfImmutable();
+    state.flush();
+    mat X_transp_AX(state.widthOfX, state.widthOfX);
+    unpackSymmetric(state.X_transp_AX.memptr(), X_transp_AX);
 
     // FIXME: Harden the code. pinv can throw an exception if 
     // matrix is ill-formed
-    state.coef = pinv(state.X_transp_AX) * state.X_transp_Az;    
+    state.coef = pinv(X_transp_AX) * state.X_transp_Az;    
     return state;
 }
 
@@ -22,11 +22,85 @@ struct LogisticRegressionCG {
     class State;
     
     static AnyValue transition(AbstractDBInterface &db, AnyValue args);
+    static AnyValue floatTransition(AbstractDBInterface &db, AnyValue args);
+    static AnyValue sparseTransition(AbstractDBInterface &db, AnyValue args);
     static AnyValue preliminary(AbstractDBInterface &db, AnyValue args);
     static AnyValue final(AbstractDBInterface &db, AnyValue args);
     
     static AnyValue distance(AbstractDBInterface &db, AnyValue args);
     static AnyValue coef(AbstractDBInterface &db, AnyValue args);
+    
+    template <class Row>
+    static AnyValue transitionStep(AbstractDBInterface &db, State &state,
+        const double y, const Row &x, AnyValue::iterator &arg,
+        const unsigned int inNumOptionalArgs);
+};
+
+/**
+ * @brief Functions for logistic regression, using a conjugate-gradient method
+ *        with one aggregate-function call per iteration
+ */
+struct LogisticRegressionFCG {
+    class State;
+    
+    static AnyValue transition(AbstractDBInterface &db, AnyValue args);
+    static AnyValue floatTransition(AbstractDBInterface &db, AnyValue args);
+    static AnyValue sparseTransition(AbstractDBInterface &db, AnyValue args);
+    static AnyValue preliminary(AbstractDBInterface &db, AnyValue args);
+    static AnyValue final(AbstractDBInterface &db, AnyValue args);
+    
+    static AnyValue distance(AbstractDBInterface &db, AnyValue args);
+    static AnyValue coef(AbstractDBInterface &db, AnyValue args);
+    
+    template <class Row>
+    static AnyValue transitionStep(AbstractDBInterface &db, State &state,
+        const double y, const Row &x, AnyValue::iterator &arg,
+        const unsigned int inNumOptionalArgs);
+};
+
+/**
+ * @brief Functions for logistic regression, using the limited-memory BFGS
+ *        method
+ */
+struct LogisticRegressionLBFGS {
+    class State;
+    
+    static AnyValue transition(AbstractDBInterface &db, AnyValue args);
+    static AnyValue floatTransition(AbstractDBInterface &db, AnyValue args);
+    static AnyValue sparseTransition(AbstractDBInterface &db, AnyValue args);
+    static AnyValue preliminary(AbstractDBInterface &db, AnyValue args);
+    static AnyValue final(AbstractDBInterface &db, AnyValue args);
+    
+    static AnyValue distance(AbstractDBInterface &db, AnyValue args);
+    static AnyValue coef(AbstractDBInterface &db, AnyValue args);
+    static AnyValue warmStart(AbstractDBInterface &db, AnyValue args);
+    
+    template <class Row>
+    static AnyValue transitionStep(AbstractDBInterface &db, State &state,
+        const double y, const Row &x, AnyValue::iterator &arg,
+        const unsigned int inNumOptionalArgs);
+};
+
+/**
+ * @brief Functions for logistic regression, using stochastic gradient descent
+ *        with model averaging
+ */
+struct LogisticRegressionSGD {
+    class State;
+    
+    static AnyValue transition(AbstractDBInterface &db, AnyValue args);
+    static AnyValue floatTransition(AbstractDBInterface &db, AnyValue args);
+    static AnyValue sparseTransition(AbstractDBInterface &db, AnyValue args);
+    static AnyValue preliminary(AbstractDBInterface &db, AnyValue args);
+    static AnyValue final(AbstractDBInterface &db, AnyValue args);
+    
+    static AnyValue distance(AbstractDBInterface &db, AnyValue args);
+    static AnyValue coef(AbstractDBInterface &db, AnyValue args);
+    
+    template <class Row>
+    static AnyValue transitionStep(AbstractDBInterface &db, State &state,
+        const double y, const Row &x, AnyValue::iterator &arg,
+        const unsigned int inNumOptionalArgs);
 };
 
 /**
@@ -37,11 +111,18 @@ struct LogisticRegressionIRLS {
     class State;
     
     static AnyValue transition(AbstractDBInterface &db, AnyValue args);
+    static AnyValue floatTransition(AbstractDBInterface &db, AnyValue args);
+    static AnyValue sparseTransition(AbstractDBInterface &db, AnyValue args);
     static AnyValue preliminary(AbstractDBInterface &db, AnyValue args);
     static AnyValue final(AbstractDBInterface &db, AnyValue args);
     
     static AnyValue distance(AbstractDBInterface &db, AnyValue args);
     static AnyValue coef(AbstractDBInterface &db, AnyValue args);
+    
+    template <class Row>
+    static AnyValue transitionStep(AbstractDBInterface &db, State &state,
+        const double y, const Row &x, AnyValue::iterator &arg,
+        const unsigned int inNumOptionalArgs);
 };
 
 } // namespace regress
@@ -0,0 +1,51 @@
+/* ----------------------------------------------------------------------- *//**
+ *
+ * @file merge.hpp
+ *
+ * @brief Preliminary aggregation step shared by the regression aggregates
+ *
+ *//* ----------------------------------------------------------------------- */
+
+#ifndef MADLIB_REGRESS_MERGE_H
+#define MADLIB_REGRESS_MERGE_H
+
+#include <madlib/modules/common.hpp>
+
+namespace madlib {
+
+namespace modules {
+
+namespace regress {
+
+/**
+ * @brief Merge the two transition states passed to a preliminary function
+ *
+ * On Greenplum, a segment without rows contributes the initial state
+ * (INITCOND), which has a different size than a state that has seen rows. If
+ * either state is still empty, the other one is returned as it is. Otherwise,
+ * the states are merged with <tt>State::operator+=</tt>.
+ *
+ * @param inArgs The arguments of the preliminary function, i.e., the two
+ *     states. Both must have a field \c numRows.
+ */
+template <class State>
+inline AnyValue mergeStates(AnyValue &inArgs) {
+    State stateLeft = inArgs[0].copyIfImmutable();
+    const State stateRight = inArgs[1];
+
+    if (stateRight.numRows == 0)
+        return stateLeft;
+    if (stateLeft.numRows == 0)
+        return inArgs[1].copyIfImmutable();
+
+    stateLeft += stateRight;
+    return stateLeft;
+}
+
+} // namespace regress
+
+} // namespace modules
+
+} // namespace madlib
+
+#endif
@@ -0,0 +1,421 @@
+/* ----------------------------------------------------------------------- *//**
+ *
+ * @file multilogistic.cpp
+ *
+ * @brief Multinomial logistic-regression functions
+ *
+ * The dependent variable is one of K categories 0, ..., K - 1. Each category
+ * k has a vector of coefficients \f$ c_k \f$, so that
+ * \f[
+ *     \Pr(y_i = k) = \frac{\exp(x_i c_k)}{\sum_{j=0}^{K-1} \exp(x_i c_j)}.
+ * \f]
+ * Adding the same vector to all \f$ c_k \f$ does not change the model. We
+ * return the coefficients with \f$ \sum_k c_k = 0 \f$.
+ *
+ * All categories are trained together, i.e., each iteration is one scan of
+ * the data, regardless of K.
+ *
+ *//* ----------------------------------------------------------------------- */
+
+#include <madlib/modules/regress/multilogistic.hpp>
+#include <madlib/modules/regress/linalg.hpp>
+#include <madlib/modules/regress/merge.hpp>
+#include <madlib/modules/regress/rows.hpp>
+#include <madlib/utils/Reference.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Import names from Armadillo
+using arma::mat;
+using arma::colvec;
+
+namespace madlib {
+
+using utils::Reference;
+
+namespace modules {
+
+namespace regress {
+
+/**
+ * @brief Inter- and intra-iteration state for multinomial logistic regression
+ *
+ * The negative Hessian of the log-likelihood is a matrix of
+ * \f$ K \times K \f$ blocks of size widthOfX x widthOfX, where block (k, l)
+ * is \f$ \sum_i A_{i,kl} x_i^T x_i \f$ with
+ * \f$ A_i = \operatorname{diag}(p_i) - p_i p_i^T \f$, and \f$ p_{ik} \f$ is
+ * the probability of category k for row i. We only keep the diagonal blocks,
+ * which makes the state and the transition step K times smaller. Since the
+ * absolute values in row k of \f$ A_i \f$ sum up to
+ * \f$ 2 p_{ik} (1 - p_{ik}) \f$, we have
+ * \f$ A_i \preceq 2 \operatorname{diag}(p_{ik} (1 - p_{ik})) \f$, so we use
+ * the weights \f$ 2 p_{ik} (1 - p_{ik}) \f$ in the diagonal blocks. With the
+ * exact diagonal blocks instead, the steps ignore that all categories move at
+ * the same time, and the method does not converge in general. The final step
+ * is a Newton step for each category with its block. For K = 2, the two steps
+ * together are exactly the IRLS step of LogisticRegressionIRLS.
+ *
+ * Note: We assume that the DOUBLE PRECISION array is initialized by the
+ * database with length at least 5, and all elemenets are 0.
+ *
+ * @internal Array layout (iteration refers to one aggregate-function call):
+ * Inter-iteration components (updated in final function):
+ * - 0: widthOfX (number of independent variables)
+ * - 1: numCategories (K)
+ * - 2: coef (matrix of coefficients, one column per category)
+ *
+ * Intra-iteration components (updated in transition step):
+ * - 2 + widthOfX * K: numRows (number of rows already processed in this
+ *   iteration)
+ * - 3 + widthOfX * K: logLikelihood ( ln(l(c)) )
+ * - 4 + widthOfX * K: grad (gradient of the log-likelihood, one column
+ *   per category)
+ * - 4 + 2 * widthOfX * K: hessianBlocks (the K diagonal blocks of
+ *   the negative Hessian, each in packed storage, see packedSize())
+ */
+class MultinomialLogisticRegression::State {
+public:
+    State(AnyValue inArg)
+        : mStorage(inArg.copyIfImmutable()),
+          widthOfX(&mStorage[0]),
+          numCategories(&mStorage[1]),
+          coef(TransparentHandle::create(&mStorage[2]),
+               widthOfX, numCategories),
+
+          numRows(&mStorage[2 + widthOfX * numCategories]),
+          logLikelihood(&mStorage[3 + widthOfX * numCategories]),
+          grad(TransparentHandle::create(
+                &mStorage[4 + widthOfX * numCategories]),
+              widthOfX, numCategories),
+          hessianBlocks(TransparentHandle::create(
+                &mStorage[4 + 2 * widthOfX * numCategories]),
+              packedSize(widthOfX), numCategories)
+        { }
+
+    /**
+     * We define this function so that we can use State in the
+     * argument list and as a return type.
+     */
+    inline operator AnyValue() {
+        return mStorage;
+    }
+
+    /**
+     * @brief Initialize the state.
+     *
+     * This function is only called for the first iteration, for the first row.
+     */
+    inline void initialize(AllocatorSPtr inAllocator,
+        const uint16_t inWidthOfX, const uint16_t inNumCategories) {
+
+        const uint32_t m = inNumCategories;
+        const uint32_t coefSize = inWidthOfX * m;
+
+        mStorage.rebind(inAllocator,
+            boost::extents[ arraySize(inWidthOfX, inNumCategories) ]);
+        widthOfX.rebind(&mStorage[0]) = inWidthOfX;
+        numCategories.rebind(&mStorage[1]) = inNumCategories;
+        coef.rebind(TransparentHandle::create(&mStorage[2]),
+                    inWidthOfX, m).zeros();
+
+        numRows.rebind(&mStorage[2 + coefSize]);
+        logLikelihood.rebind(&mStorage[3 + coefSize]);
+        grad.rebind(TransparentHandle::create(&mStorage[4 + coefSize]),
+                    inWidthOfX, m);
+        hessianBlocks.rebind(TransparentHandle::create(
+                                 &mStorage[4 + 2 * coefSize]),
+                             packedSize(inWidthOfX), m);
+        reset();
+    }
+
+    /**
+     * @brief We need to support assigning the previous state
+     */
+    State &operator=(const State &inOtherState) {
+        mStorage = inOtherState.mStorage;
+        return *this;
+    }
+
+    /**
+     * @brief Add a row to the intra-iteration fields
+     *
+     * The probabilities are computed relative to the largest score, so the
+     * exponentials never overflow.
+     */
+    template <class Row>
+    inline void addRow(const uint16_t inY, const Row &inX) {
+        colvec scores(numCategories);
+        uint16_t argMax = 0;
+        for (uint16_t k = 0; k < numCategories; k++) {
+            scores(k) = rowDot(inX, coef.colptr(k));
+            if (scores(k) > scores(argMax))
+                argMax = k;
+        }
+        const double maxScore = scores(argMax);
+
+        // The term of argMax is exp(0) = 1. We keep the sum of the others
+        // separately, so that 1 - p is accurate even if p is close to 1.
+        colvec expScores(numCategories);
+        double sumExpOthers = 0;
+        for (uint16_t k = 0; k < numCategories; k++) {
+            expScores(k) = std::exp(scores(k) - maxScore);
+            if (k != argMax)
+                sumExpOthers += expScores(k);
+        }
+        const double sumExp = 1. + sumExpOthers;
+
+        // ln Pr(y_i) = x_i c_{y_i} - ln(sum_j exp(x_i c_j))
+        logLikelihood += scores(inY) - maxScore - std::log(sumExp);
+
+        for (uint16_t k = 0; k < numCategories; k++) {
+            const double p = expScores(k) / sumExp;
+            const double pNeg = k == argMax
+                ? sumExpOthers / sumExp
+                : (sumExp - expScores(k)) / sumExp;
+
+            addScaledRow(grad.colptr(k), (inY == k ? 1. : 0.) - p, inX);
+
+            packedRankOneUpdate(hessianBlocks.colptr(k), widthOfX,
+                rowElements(inX), 2. * p * pNeg);
+        }
+    }
+
+    /**
+     * @brief Merge with another State object by copying the intra-iteration
+     *     fields
+     */
+    State &operator+=(const State &inOtherState) {
+        if (mStorage.size() != inOtherState.mStorage.size() ||
+            widthOfX != inOtherState.widthOfX ||
+            numCategories != inOtherState.numCategories)
+            throw std::logic_error("Internal error: Incompatible transition states");
+
+        // grad and hessianBlocks are adjacent in the array
+        const uint64_t coefSize = static_cast<uint64_t>(widthOfX)
+            * numCategories;
+        numRows += inOtherState.numRows;
+        logLikelihood += inOtherState.logLikelihood;
+        addRange(mStorage, inOtherState.mStorage, 4 + coefSize,
+            coefSize + packedSize(widthOfX) * numCategories);
+        return *this;
+    }
+
+    /**
+     * @brief Reset the intra-iteration fields.
+     */
+    inline void reset() {
+        numRows = 0;
+        logLikelihood = 0;
+        grad.zeros();
+        hessianBlocks.zeros();
+    }
+
+    /**
+     * @brief Size of the state array, or 0 if it is too large for an array
+     */
+    static inline uint32_t arraySize(const uint16_t inWidthOfX,
+        const uint16_t inNumCategories) {
+
+        const uint64_t coefSize = static_cast<uint64_t>(inWidthOfX)
+            * inNumCategories;
+        const uint64_t size = 4 + 2 * coefSize
+            + packedSize(inWidthOfX) * inNumCategories;
+
+        return size > std::numeric_limits<uint32_t>::max()
+            ? 0
+            : static_cast<uint32_t>(size);
+    }
+
+private:
+    Array<double> mStorage;
+
+public:
+    Reference<double, uint16_t> widthOfX;
+    Reference<double, uint16_t> numCategories;
+    DoubleMat coef;
+
+    Reference<double, uint64_t> numRows;
+    Reference<double> logLikelihood;
+    DoubleMat grad;
+    DoubleMat hessianBlocks;
+};
+
+/**
+ * @brief Perform the multinomial logistic-regression transition step
+ *
+ * The arguments are the state, the category of the dependent variable
+ * (INTEGER between 0 and K - 1), the independent variables, the previous
+ * state, and the number of categories K. K is only read for the first row of
+ * each iteration.
+ */
+AnyValue MultinomialLogisticRegression::transition(AbstractDBInterface &db,
+    AnyValue args) {
+
+    AnyValue::iterator arg(args);
+
+    State state = *arg++;
+    int32_t y = arg++.getAs<int32_t>();
+    DoubleRow_const x = arg++.getAs<DoubleRow_const>();
+
+    return transitionStep(db, state, y, x, arg);
+}
+
+/**
+ * @brief Perform the transition step for a single-precision row
+ *
+ * The arguments are as for transition(), except that the independent
+ * variables are of type REAL[].
+ */
+AnyValue MultinomialLogisticRegression::floatTransition(
+    AbstractDBInterface &db, AnyValue args) {
+
+    AnyValue::iterator arg(args);
+
+    State state = *arg++;
+    int32_t y = arg++.getAs<int32_t>();
+    FloatRow_const x = arg++.getAs<Array_const<float> >();
+
+    return transitionStep(db, state, y, x, arg);
+}
+
+/**
+ * @brief Perform the transition step for a sparse row
+ *
+ * The independent variables are given by their one-based positions, their
+ * values, and their number. Otherwise, the arguments are as for transition().
+ */
+AnyValue MultinomialLogisticRegression::sparseTransition(
+    AbstractDBInterface &db, AnyValue args) {
+
+    AnyValue::iterator arg(args);
+
+    State state = *arg++;
+    int32_t y = arg++.getAs<int32_t>();
+    SparseVector_const x = sparseRowArg(arg);
+
+    return transitionStep(db, state, y, x, arg);
+}
+
+/**
+ * @brief Transition step common to dense and sparse rows
+ *
+ * @param arg Iterator pointing to the previous state
+ */
+template <class Row>
+AnyValue MultinomialLogisticRegression::transitionStep(
+    AbstractDBInterface &db, State &state, const int32_t y, const Row &x,
+    AnyValue::iterator &arg) {
+
+    if (state.numRows == 0) {
+        if (x.n_elem > std::numeric_limits<uint16_t>::max())
+            throw std::invalid_argument("Number of independent variables "
+                "cannot be larger than 65535");
+
+        const AnyValue previousStateArg = *arg++;
+        const int32_t numCategories = arg.getAs<int32_t>();
+        if (numCategories < 2 ||
+            numCategories > std::numeric_limits<uint16_t>::max())
+            throw std::invalid_argument("Number of categories must be between "
+                "2 and 65535");
+        if (State::arraySize(x.n_elem, numCategories) == 0)
+            throw std::invalid_argument("Number of independent variables and "
+                "categories too large");
+
+        state.initialize(db.allocator(AbstractAllocator::kAggregate),
+            x.n_elem, numCategories);
+        if (!previousStateArg.isNull()) {
+            const State previousState = previousStateArg;
+
+            if (previousState.widthOfX != state.widthOfX ||
+                previousState.numCategories != state.numCategories)
+                throw std::invalid_argument("Previous state has different "
+                    "numbers of independent variables or categories");
+            state.coef = previousState.coef;
+        }
+    }
+    if (x.n_elem != state.widthOfX)
+        throw std::invalid_argument("Inconsistent numbers of independent variables");
+    if (y < 0 || y >= state.numCategories)
+        throw std::out_of_range("Dependent variable must be between 0 and "
+            "the number of categories minus 1");
+
+    // Now do the transition step
+    state.numRows++;
+    state.addRow(static_cast<uint16_t>(y), x);
+    return state;
+}
+
+/**
+ * @brief Perform the perliminary aggregation function: Merge transition states
+ */
+AnyValue MultinomialLogisticRegression::preliminary(AbstractDBInterface &db,
+    AnyValue args) {
+    return mergeStates<State>(args);
+}
+
+/**
+ * @brief Perform the multinomial logistic-regression final step
+ *
+ * For each category k, we solve
+ * \f$ H_{kk} \, \Delta c_k = \nabla_{c_k} \ln(l(c)) \f$ with the
+ * approximate diagonal block \f$ H_{kk} \f$ and update \f$ c_k \f$ by
+ * \f$ \Delta c_k \f$.
+ */
+AnyValue MultinomialLogisticRegression::final(AbstractDBInterface &db,
+    AnyValue args) {
+
+    // Argument from SQL call
+    State state = args[0].copyIfImmutable();
+
+    mat block(state.widthOfX, state.widthOfX);
+    for (uint16_t k = 0; k < state.numCategories; k++) {
+        unpackSymmetric(state.hessianBlocks.colptr(k), block);
+
+        // FIXME: Harden the code. pinv can throw an exception if
+        // matrix is ill-formed
+        state.coef.col(k) += pinv(block) * state.grad.col(k);
+    }
+
+    // Normalize so that the coefficients of all categories sum up to 0
+    colvec meanCoef = state.coef.col(0);
+    for (uint16_t k = 1; k < state.numCategories; k++)
+        meanCoef += state.coef.col(k);
+    meanCoef /= state.numCategories;
+    for (uint16_t k = 0; k < state.numCategories; k++)
+        state.coef.col(k) -= meanCoef;
+    return state;
+}
+
+/**
+ * @brief Return the difference in log-likelihood between two states
+ */
+AnyValue MultinomialLogisticRegression::distance(AbstractDBInterface &db,
+    AnyValue args) {
+
+    const State stateLeft = args[0];
+    const State stateRight = args[1];
+
+    return std::abs(stateLeft.logLikelihood - stateRight.logLikelihood);
+}
+
+/**
+ * @brief Return the coefficients of the state
+ *
+ * The result is a one-dimensional array with the coefficients of categories
+ * 0, ..., K - 1 one after another.
+ */
+AnyValue MultinomialLogisticRegression::coef(AbstractDBInterface &db,
+    AnyValue args) {
+
+    const State state = args[0];
+
+    return state.coef;
+}
+
+} // namespace regress
+
+} // namespace modules
+
+} // namespace madlib
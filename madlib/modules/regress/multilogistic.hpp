@@ -0,0 +1,45 @@
+/* ----------------------------------------------------------------------- *//**
+ *
+ * @file multilogistic.hpp
+ *
+ *//* ----------------------------------------------------------------------- */
+
+#ifndef MADLIB_REGRESS_MULTILOGISTIC_H
+#define MADLIB_REGRESS_MULTILOGISTIC_H
+
+#include <madlib/modules/common.hpp>
+
+namespace madlib {
+
+namespace modules {
+
+namespace regress {
+
+/**
+ * @brief Functions for multinomial logistic regression, using a Newton method
+ *        with a block-diagonal Hessian
+ */
+struct MultinomialLogisticRegression {
+    class State;
+
+    static AnyValue transition(AbstractDBInterface &db, AnyValue args);
+    static AnyValue floatTransition(AbstractDBInterface &db, AnyValue args);
+    static AnyValue sparseTransition(AbstractDBInterface &db, AnyValue args);
+    static AnyValue preliminary(AbstractDBInterface &db, AnyValue args);
+    static AnyValue final(AbstractDBInterface &db, AnyValue args);
+
+    static AnyValue distance(AbstractDBInterface &db, AnyValue args);
+    static AnyValue coef(AbstractDBInterface &db, AnyValue args);
+
+    template <class Row>
+    static AnyValue transitionStep(AbstractDBInterface &db, State &state,
+        const int32_t y, const Row &x, AnyValue::iterator &arg);
+};
+
+} // namespace regress
+
+} // namespace modules
+
+} // namespace madlib
+
+#endif
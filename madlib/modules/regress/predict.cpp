@@ -0,0 +1,97 @@
+/* ----------------------------------------------------------------------- *//**
+ *
+ * @file predict.cpp
+ *
+ * @brief Prediction with linear and logistic-regression models
+ *
+ * Scoring is called once per row, with the same coefficients for every row.
+ * The DBAL does not copy immutable arrays, and the PostgreSQL port detoasts
+ * the coefficients only once per call site (see PGCallSiteCache::detoast()),
+ * so the cost per row is essentially that of the dot product.
+ *
+ *//* ----------------------------------------------------------------------- */
+
+#include <madlib/modules/regress/predict.hpp>
+#include <madlib/modules/regress/dot.hpp>
+#include <madlib/modules/regress/sigmoid.hpp>
+
+#include <stdexcept>
+
+namespace madlib {
+
+namespace modules {
+
+namespace regress {
+
+namespace {
+
+inline void checkWidth(size_t inNumCoef, size_t inWidthOfX) {
+    if (inNumCoef != inWidthOfX)
+        throw std::invalid_argument("Number of coefficients does not match "
+            "number of independent variables");
+}
+
+/**
+ * @brief \f$ c^T x \f$ for dense independent variables with element type T
+ */
+template <typename T>
+double linearPredictor(AnyValue &args) {
+    AnyValue::iterator arg(args);
+
+    Array_const<double> coef = arg++.getAs<Array_const<double> >();
+    Array_const<T> x = arg.getAs<Array_const<T> >();
+    checkWidth(coef.size(), x.size());
+
+    return dot(x.data(), coef.data(), x.size());
+}
+
+/**
+ * @brief \f$ c^T x \f$ for sparse independent variables
+ */
+double sparseLinearPredictor(AnyValue &args) {
+    AnyValue::iterator arg(args);
+
+    Array_const<double> coef = arg++.getAs<Array_const<double> >();
+    Array_const<int32_t> indices = arg++.getAs<Array_const<int32_t> >();
+    Array_const<double> values = arg.getAs<Array_const<double> >();
+
+    // The constructor verifies that all indices are within the coefficients
+    SparseVector_const x(indices, values, static_cast<uint32_t>(coef.size()));
+    return x.dot(coef.data());
+}
+
+} // namespace
+
+AnyValue linreg_predict(AbstractDBInterface & /* db */, AnyValue args) {
+    return linearPredictor<double>(args);
+}
+
+AnyValue linreg_float_predict(AbstractDBInterface & /* db */, AnyValue args) {
+    return linearPredictor<float>(args);
+}
+
+AnyValue linreg_sparse_predict(AbstractDBInterface & /* db */,
+    AnyValue args) {
+
+    return sparseLinearPredictor(args);
+}
+
+AnyValue logreg_predict(AbstractDBInterface & /* db */, AnyValue args) {
+    return sigma(linearPredictor<double>(args));
+}
+
+AnyValue logreg_float_predict(AbstractDBInterface & /* db */, AnyValue args) {
+    return sigma(linearPredictor<float>(args));
+}
+
+AnyValue logreg_sparse_predict(AbstractDBInterface & /* db */,
+    AnyValue args) {
+
+    return sigma(sparseLinearPredictor(args));
+}
+
+} // namespace regress
+
+} // namespace modules
+
+} // namespace madlib
@@ -0,0 +1,72 @@
+/* ----------------------------------------------------------------------- *//**
+ *
+ * @file predict.hpp
+ *
+ * @brief Prediction with linear and logistic-regression models
+ *
+ *//* ----------------------------------------------------------------------- */
+
+#ifndef MADLIB_REGRESS_PREDICT_H
+#define MADLIB_REGRESS_PREDICT_H
+
+#include <madlib/modules/common.hpp>
+
+namespace madlib {
+
+namespace modules {
+
+namespace regress {
+
+/**
+ * @brief Predicted value \f$ c^T x \f$ of a linear-regression model
+ *
+ * The arguments are the coefficients (DOUBLE PRECISION[]) and the independent
+ * variables (DOUBLE PRECISION[]).
+ */
+AnyValue linreg_predict(AbstractDBInterface &db, AnyValue args);
+
+/**
+ * @brief Predicted value of a linear-regression model for REAL[] independent
+ *     variables
+ */
+AnyValue linreg_float_predict(AbstractDBInterface &db, AnyValue args);
+
+/**
+ * @brief Predicted value of a linear-regression model for sparse independent
+ *     variables
+ *
+ * The arguments are the coefficients (DOUBLE PRECISION[]), the one-based
+ * positions of the non-zero independent variables (INTEGER[]), and their
+ * values (DOUBLE PRECISION[]).
+ */
+AnyValue linreg_sparse_predict(AbstractDBInterface &db, AnyValue args);
+
+/**
+ * @brief Predicted probability \f$ \sigma(c^T x) \f$ of a logistic-regression
+ *     model
+ *
+ * The arguments are as for linreg_predict().
+ */
+AnyValue logreg_predict(AbstractDBInterface &db, AnyValue args);
+
+/**
+ * @brief Predicted probability of a logistic-regression model for REAL[]
+ *     independent variables
+ */
+AnyValue logreg_float_predict(AbstractDBInterface &db, AnyValue args);
+
+/**
+ * @brief Predicted probability of a logistic-regression model for sparse
+ *     independent variables
+ *
+ * The arguments are as for linreg_sparse_predict().
+ */
+AnyValue logreg_sparse_predict(AbstractDBInterface &db, AnyValue args);
+
+} // namespace regress
+
+} // namespace modules
+
+} // namespace madlib
+
+#endif
@@ -0,0 +1,159 @@
+/* ----------------------------------------------------------------------- *//**
+ *
+ * @file rows.hpp
+ *
+ * @brief Dense and sparse rows of independent variables
+ *
+ * The regression transition functions are templates in the type of the row,
+ * which is DoubleRow_const, FloatRow_const, or SparseVector_const. The
+ * functions in this file are overloaded for all of them, so that the cost per
+ * row of the sparse variants is proportional to the number of non-zero
+ * elements, and so that single-precision rows are never copied. All sums are
+ * accumulated in double precision.
+ *
+ *//* ----------------------------------------------------------------------- */
+
+#ifndef MADLIB_REGRESS_ROWS_H
+#define MADLIB_REGRESS_ROWS_H
+
+#include <madlib/modules/common.hpp>
+#include <madlib/modules/regress/dot.hpp>
+
+#include <stdexcept>
+
+namespace madlib {
+
+namespace modules {
+
+namespace regress {
+
+/**
+ * @brief Dense row of single-precision independent variables
+ *
+ * This is a view on a REAL[] argument. Elements are converted to double
+ * precision only when they are used, which halves the size of the feature
+ * data compared to DOUBLE PRECISION[].
+ */
+class FloatRow_const {
+public:
+    inline FloatRow_const(const Array_const<float> &inArray)
+        : mArray(inArray),
+          n_elem(static_cast<uint32_t>(inArray.size()))
+        { }
+    
+    inline const float *memptr() const {
+        return mArray.data();
+    }
+
+protected:
+    Array_const<float> mArray;
+
+public:
+    const uint32_t n_elem;
+};
+
+/**
+ * @brief Read a sparse row from three consecutive function arguments
+ *
+ * The arguments are the one-based positions of the non-zero elements
+ * (INTEGER[]), their values (DOUBLE PRECISION[]), and the number of
+ * independent variables (INTEGER).
+ */
+inline SparseVector_const sparseRowArg(AnyValue::iterator &ioArg) {
+    Array_const<int32_t> indices = ioArg++.getAs<Array_const<int32_t> >();
+    Array_const<double> values = ioArg++.getAs<Array_const<double> >();
+    int32_t numElem = ioArg++.getAs<int32_t>();
+    if (numElem < 0)
+        throw std::invalid_argument("Number of independent variables must "
+            "not be negative");
+
+    return SparseVector_const(indices, values, numElem);
+}
+
+/**
+ * @brief Dot product \f$ x c \f$ of a row with a column vector
+ *
+ * Dense rows use the vectorized kernels in dot.hpp. The column vector is
+ * given by a pointer to its first element, e.g., a column of a coefficient
+ * matrix.
+ */
+inline double rowDot(const DoubleRow_const &inX, const double *inC) {
+    return dot(inX.memptr(), inC, inX.n_elem);
+}
+
+inline double rowDot(const FloatRow_const &inX, const double *inC) {
+    return dot(inX.memptr(), inC, inX.n_elem);
+}
+
+inline double rowDot(const SparseVector_const &inX, const double *inC) {
+    return inX.dot(inC);
+}
+
+template <class Row>
+inline double rowDot(const Row &inX, const arma::Col<double> &inC) {
+    return rowDot(inX, inC.memptr());
+}
+
+/**
+ * @brief Add a multiple of the transposed row: \f$ v += \alpha x^T \f$
+ */
+inline void addScaledRow(double *ioV, const double inAlpha,
+    const DoubleRow_const &inX) {
+
+    const double *x = inX.memptr();
+    for (uint32_t i = 0; i < inX.n_elem; i++)
+        ioV[i] += inAlpha * x[i];
+}
+
+inline void addScaledRow(double *ioV, const double inAlpha,
+    const FloatRow_const &inX) {
+
+    const float *x = inX.memptr();
+    for (uint32_t i = 0; i < inX.n_elem; i++)
+        ioV[i] += inAlpha * x[i];
+}
+
+inline void addScaledRow(double *ioV, const double inAlpha,
+    const SparseVector_const &inX) {
+
+    inX.addTo(ioV, inAlpha);
+}
+
+inline void addScaledRow(arma::Col<double> &ioV, const double inAlpha,
+    const DoubleRow_const &inX) {
+
+    ioV += inAlpha * arma::trans(inX);
+}
+
+template <class Row>
+inline void addScaledRow(arma::Col<double> &ioV, const double inAlpha,
+    const Row &inX) {
+
+    addScaledRow(ioV.memptr(), inAlpha, inX);
+}
+
+/**
+ * @brief Argument for the addRow() functions of the transition states
+ *
+ * Dense rows are passed as pointer to the first element, sparse rows as they
+ * are.
+ */
+inline const double *rowElements(const DoubleRow_const &inX) {
+    return inX.memptr();
+}
+
+inline const float *rowElements(const FloatRow_const &inX) {
+    return inX.memptr();
+}
+
+inline const SparseVector_const &rowElements(const SparseVector_const &inX) {
+    return inX;
+}
+
+} // namespace regress
+
+} // namespace modules
+
+} // namespace madlib
+
+#endif
@@ -0,0 +1,139 @@
+/* ----------------------------------------------------------------------- *//**
+ *
+ * @file sigmoid.cpp
+ *
+ * @brief Block version of the logistic-regression row terms
+ *
+ *//* ----------------------------------------------------------------------- */
+
+#include <madlib/modules/regress/sigmoid.hpp>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace madlib {
+
+namespace modules {
+
+namespace regress {
+
+#if defined(__SSE2__)
+
+namespace {
+
+/**
+ * @brief \f$ \exp(x) \f$ for two arguments \f$ x \leq 0 \f$
+ *
+ * We write \f$ x = k \ln 2 + r \f$ with integer k and
+ * \f$ |r| \leq \ln(2) / 2 \f$, evaluate the Taylor polynomial of degree 12 for
+ * \f$ \exp(r) \f$, and multiply by \f$ 2^k \f$ in two steps so that subnormal
+ * results are handled correctly. Arguments below -746 yield 0.
+ */
+inline __m128d expNonPositive(__m128d inX) {
+    const __m128d kMinArg = _mm_set1_pd(-746.);
+    const __m128d kLog2e = _mm_set1_pd(1.4426950408889634);
+    // Cody-Waite splitting of ln(2)
+    const __m128d kLn2Hi = _mm_set1_pd(6.93147180369123816490e-01);
+    const __m128d kLn2Lo = _mm_set1_pd(1.90821492927058770002e-10);
+
+    __m128d underflow = _mm_cmplt_pd(inX, kMinArg);
+    // Operands are in this order so that NaN is propagated
+    __m128d x = _mm_max_pd(kMinArg, inX);
+
+    // Rounds to nearest with the default MXCSR
+    __m128i k32 = _mm_cvtpd_epi32(_mm_mul_pd(x, kLog2e));
+    __m128d k = _mm_cvtepi32_pd(k32);
+    __m128d r = _mm_sub_pd(_mm_sub_pd(x, _mm_mul_pd(k, kLn2Hi)),
+        _mm_mul_pd(k, kLn2Lo));
+
+    __m128d p = _mm_set1_pd(1. / 479001600);
+    p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(1. / 39916800));
+    p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(1. / 3628800));
+    p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(1. / 362880));
+    p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(1. / 40320));
+    p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(1. / 5040));
+    p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(1. / 720));
+    p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(1. / 120));
+    p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(1. / 24));
+    p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(1. / 6));
+    p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(1. / 2));
+    p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(1.));
+    p = _mm_add_pd(_mm_mul_pd(p, r), _mm_set1_pd(1.));
+
+    // 2^k = 2^k1 * 2^k2 with k1 = floor(k / 2). Both factors are normal.
+    __m128i k1 = _mm_srai_epi32(k32, 1);
+    __m128i k2 = _mm_sub_epi32(k32, k1);
+    const __m128i kBias = _mm_set_epi32(0, 1023, 0, 1023);
+    __m128i e1 = _mm_slli_epi64(_mm_add_epi64(
+        _mm_unpacklo_epi32(k1, _mm_srai_epi32(k1, 31)), kBias), 52);
+    __m128i e2 = _mm_slli_epi64(_mm_add_epi64(
+        _mm_unpacklo_epi32(k2, _mm_srai_epi32(k2, 31)), kBias), 52);
+    p = _mm_mul_pd(_mm_mul_pd(p, _mm_castsi128_pd(e1)), _mm_castsi128_pd(e2));
+
+    return _mm_andnot_pd(underflow, p);
+}
+
+/**
+ * @brief log1pUnit() for two arguments
+ */
+inline __m128d log1pUnit(__m128d inX) {
+    __m128d s = _mm_div_pd(inX, _mm_add_pd(_mm_set1_pd(2.), inX));
+    __m128d s2 = _mm_mul_pd(s, s);
+    __m128d p = _mm_set1_pd(1. / 35);
+    for (int k = 33; k >= 1; k -= 2)
+        p = _mm_add_pd(_mm_mul_pd(p, s2), _mm_set1_pd(1. / k));
+    return _mm_mul_pd(_mm_add_pd(s, s), p);
+}
+
+} // namespace
+
+#endif
+
+double logisticTermsBlock(const double *inX, double *outSigma,
+    double *outSigmaNeg, arma::u32 inN) {
+
+    double logSigmaSum = 0;
+    arma::u32 i = 0;
+
+#if defined(__SSE2__)
+    const __m128d kSignMask = _mm_set1_pd(-0.);
+    const __m128d kOne = _mm_set1_pd(1.);
+    const __m128d kZero = _mm_setzero_pd();
+    __m128d logSigmaSums = kZero;
+
+    for (; i + 2 <= inN; i += 2) {
+        __m128d x = _mm_loadu_pd(inX + i);
+        __m128d e = expNonPositive(_mm_or_pd(x, kSignMask));  // exp(-|x|)
+        __m128d onePlusE = _mm_add_pd(kOne, e);
+        __m128d small = _mm_div_pd(e, onePlusE);
+        __m128d large = _mm_div_pd(kOne, onePlusE);
+
+        __m128d isNonNegative = _mm_cmpge_pd(x, kZero);
+        _mm_storeu_pd(outSigma + i, _mm_or_pd(
+            _mm_and_pd(isNonNegative, large),
+            _mm_andnot_pd(isNonNegative, small)));
+        _mm_storeu_pd(outSigmaNeg + i, _mm_or_pd(
+            _mm_and_pd(isNonNegative, small),
+            _mm_andnot_pd(isNonNegative, large)));
+
+        // ln sigma(x) = min(x, 0) - ln(1 + e). Again, NaN is propagated.
+        logSigmaSums = _mm_add_pd(logSigmaSums,
+            _mm_sub_pd(_mm_min_pd(kZero, x), log1pUnit(e)));
+    }
+
+    double partialSums[2];
+    _mm_storeu_pd(partialSums, logSigmaSums);
+    logSigmaSum = partialSums[0] + partialSums[1];
+#endif
+
+    for (; i < inN; i++)
+        logSigmaSum += logisticTerms(inX[i], outSigma[i], outSigmaNeg[i]);
+    return logSigmaSum;
+}
+
+} // namespace regress
+
+} // namespace modules
+
+} // namespace madlib
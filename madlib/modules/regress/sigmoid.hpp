@@ -0,0 +1,131 @@
+/* ----------------------------------------------------------------------- *//**
+ *
+ * @file sigmoid.hpp
+ *
+ * @brief Numerically stable logistic function and log-likelihood terms
+ *
+ *//* ----------------------------------------------------------------------- */
+
+#ifndef MADLIB_REGRESS_SIGMOID_H
+#define MADLIB_REGRESS_SIGMOID_H
+
+#include <madlib/modules/common.hpp>
+
+#include <cmath>
+
+namespace madlib {
+
+namespace modules {
+
+namespace regress {
+
+/**
+ * @brief \f$ \ln(1 + x) \f$ for \f$ 0 \leq x \leq 1 \f$
+ *
+ * We use \f$ \ln(1 + x) = 2 \operatorname{artanh}(s) \f$ with
+ * \f$ s = x / (2 + x) \in [0, 1/3] \f$. Unlike computing \f$ \ln(1 + x) \f$
+ * directly, this does not lose precision when x is small. The series is
+ * truncated after the term of degree 35, i.e., the relative truncation error
+ * is below \f$ 10^{-17} \f$.
+ */
+inline double log1pUnit(const double inX) {
+    const double s = inX / (2. + inX);
+    const double s2 = s * s;
+    double p = 1. / 35;
+    for (int k = 33; k >= 1; k -= 2)
+        p = p * s2 + 1. / k;
+    return 2. * s * p;
+}
+
+/**
+ * @brief Logistic function \f$ \sigma(x) = 1 / (1 + \exp(-x)) \f$
+ *
+ * The exponential is only evaluated for non-positive arguments, so it never
+ * overflows.
+ */
+inline double sigma(const double inX) {
+    if (inX >= 0)
+        return 1. / (1. + std::exp(-inX));
+
+    const double e = std::exp(inX);
+    return e / (1. + e);
+}
+
+/**
+ * @brief \f$ \ln(1 + \exp(x)) \f$ for a given \f$ e = \exp(-|x|) \f$
+ *
+ * We use \f$ \ln(1 + \exp(x)) = \max(x, 0) + \ln(1 + e) \f$. This is for
+ * callers that need \f$ e \f$ anyway, so that no second exponential is
+ * computed.
+ */
+inline double log1pexp(const double inX, const double inExpNegAbsX) {
+    return inX > 0
+        ? inX + log1pUnit(inExpNegAbsX)
+        : log1pUnit(inExpNegAbsX);
+}
+
+/**
+ * @brief \f$ \ln(1 + \exp(x)) \f$ without overflow or cancellation
+ *
+ * For large x, this is x (and not infinity). For very negative x, this is
+ * \f$ \exp(x) \f$ (and not 0).
+ */
+inline double log1pexp(const double inX) {
+    return log1pexp(inX, std::exp(-std::fabs(inX)));
+}
+
+/**
+ * @brief All terms that logistic regression needs for one row
+ *
+ * With \f$ e = \exp(-|x|) \f$, we have \f$ \sigma(|x|) = 1 / (1 + e) \f$,
+ * \f$ \sigma(-|x|) = e / (1 + e) \f$, and
+ * \f$ \ln \sigma(x) = -\ln(1 + \exp(-x)) \f$, which log1pexp() computes
+ * from the same \f$ e \f$. Hence, a single exponential is sufficient.
+ *
+ * @param inX Margin \f$ x = y_i \cdot c^T x_i \f$
+ * @param outSigma \f$ \sigma(x) \f$
+ * @param outSigmaNeg \f$ \sigma(-x) = 1 - \sigma(x) \f$, computed without
+ *     cancellation
+ * @return \f$ \ln \sigma(x) = -\ln(1 + \exp(-x)) \f$, i.e., the contribution
+ *     of the row to the log-likelihood
+ */
+inline double logisticTerms(const double inX, double &outSigma,
+    double &outSigmaNeg) {
+
+    const double e = std::exp(-std::fabs(inX));
+    const double small = e / (1. + e);
+    const double large = 1. / (1. + e);
+
+    if (inX >= 0) {
+        outSigma = large;
+        outSigmaNeg = small;
+    } else {
+        outSigma = small;
+        outSigmaNeg = large;
+    }
+    return -log1pexp(-inX, e);
+}
+
+/**
+ * @brief Compute logisticTerms() for a block of margins
+ *
+ * On x86 processors with SSE2, two margins are processed at a time with a
+ * vectorized exponential. Results agree with logisticTerms() up to a few
+ * units in the last place.
+ *
+ * @param inX Margins
+ * @param outSigma \f$ \sigma(x_i) \f$
+ * @param outSigmaNeg \f$ \sigma(-x_i) \f$
+ * @param inN Number of margins
+ * @return Sum of \f$ \ln \sigma(x_i) \f$
+ */
+double logisticTermsBlock(const double *inX, double *outSigma,
+    double *outSigmaNeg, arma::u32 inN);
+
+} // namespace regress
+
+} // namespace modules
+
+} // namespace madlib
+
+#endif
@@ -56,6 +56,74 @@ namespace greenplum {
 
 static void *sHandleMADlib = NULL;
 
+// The UDFs are resolved once, when this library is loaded. The declarations
+// are expanded three times: For the indices into the dispatch table, for the
+// symbol names, and finally for the UDFs themselves.
+
+#define DECLARE_UDF(NameSpace, Function) DECLARE_UDF_EXT(Function, NameSpace, Function)
+
+#define DECLARE_UDF_EXT(SQLName, NameSpace, Function) \
+    kFunction_ ## SQLName,
+
+enum FunctionIndex {
+#include <madlib/modules/declarations.hpp>
+    kNumFunctions
+};
+
+#undef DECLARE_UDF_EXT
+
+#define DECLARE_UDF_EXT(SQLName, NameSpace, Function) \
+    "madlib_" #SQLName,
+
+static const char *const sSymbolNames[kNumFunctions] = {
+#include <madlib/modules/declarations.hpp>
+};
+
+#undef DECLARE_UDF_EXT
+#undef DECLARE_UDF
+
+/**
+ * @brief Dispatch table: The functions in libmad.so, NULL if not found
+ */
+static MADFunction *sFunctions[kNumFunctions];
+
+/**
+ * @brief Look up all functions in libmad.so
+ *
+ * Missing symbols are reported once here, with a single warning. Calling a
+ * UDF whose symbol is missing raises an error (see reportMissingFunction()).
+ */
+static void resolveFunctions() {
+    unsigned int numMissing = 0;
+    const char *firstMissing = NULL;
+    char firstError[256] = "";
+
+    for (int i = 0; i < kNumFunctions; i++) {
+        dlerror();
+        sFunctions[i] = reinterpret_cast<MADFunction*>(
+            dlsym(sHandleMADlib, sSymbolNames[i]));
+        const char *error = dlerror();
+        if (error == NULL)
+            continue;
+        
+        sFunctions[i] = NULL;
+        if (numMissing++ == 0) {
+            firstMissing = sSymbolNames[i];
+            strncpy(firstError, error, sizeof(firstError));
+            firstError[sizeof(firstError) - 1] = '\0';
+        }
+    }
+
+    if (numMissing > 0) {
+        ereport(WARNING,
+            (errmsg("%u of %d functions (including %s) cannot be found in "
+                "libmad.so. MADlib will not work correctly.",
+                numMissing, static_cast<int>(kNumFunctions), firstMissing),
+            errhint("The MADlib installation could be broken"),
+            errdetail("%s", firstError)));
+    }
+}
+
 __attribute__((constructor))
 void madlib_constructor() {
     dlerror();
@@ -64,7 +132,9 @@ void madlib_constructor() {
         ereport(WARNING,
             (errmsg("libmad.so not found. MADlib will not work correctly."),
             errdetail("%s", dlerror())));
+        return;
     }
+    resolveFunctions();
 }
 
 __attribute__((destructor))
@@ -77,27 +147,14 @@ extern "C" {
     PG_MODULE_MAGIC;
 } // extern "C"
 
-#define DECLARE_UDF(NameSpace, Function) DECLARE_UDF_EXT(Function, NameSpace, Function)
-
-#define DECLARE_UDF_EXT(SQLName, NameSpace, Function) \
-    extern "C" { \
-        Datum SQLName(PG_FUNCTION_ARGS); \
-        PG_FUNCTION_INFO_V1(SQLName); \
-        Datum SQLName(PG_FUNCTION_ARGS) { \
-            static MADFunction *f = NULL; \
-            if (f == NULL) \
-                f = reinterpret_cast<MADFunction*>( \
-                    getFnHandle("madlib_" #SQLName, fcinfo) \
-                ); \
-            return call( (*f), fcinfo); \
-        } \
-    }
-    
-static void *getFnHandle(const char *inFnName, PG_FUNCTION_ARGS) {
+/**
+ * @brief Raise an error for a UDF that is not in the dispatch table
+ */
+static void reportMissingFunction(PG_FUNCTION_ARGS) {
     if (sHandleMADlib == NULL) {
         ereport(
             ERROR, (
-                errmsg( \
+                errmsg(
                     "Function \"%s\": libmad.so not found. "
                     "MADlib will not work correclty.",
                     format_procedure(fcinfo->flinfo->fn_oid)
@@ -108,26 +165,32 @@ static void *getFnHandle(const char *inFnName, PG_FUNCTION_ARGS) {
         // This position will not be reached
     }
 
-    dlerror();
-    void *fnHandle = dlsym(sHandleMADlib, inFnName);
-    char *error = dlerror();
-    if (error != NULL) {
-        ereport(
-            ERROR, (
-                errmsg(
-                    "Function \"%s\" cannot be found in libmad.so",
-                    format_procedure(fcinfo->flinfo->fn_oid)
-                ),
-                errhint("The MADlib installation could be broken"),
-                errdetail("%s", error)
-            )
-        );
-        // This position will not be reached
-    }
-    
-    return fnHandle;
+    ereport(
+        ERROR, (
+            errmsg(
+                "Function \"%s\" cannot be found in libmad.so",
+                format_procedure(fcinfo->flinfo->fn_oid)
+            ),
+            errhint("The MADlib installation could be broken")
+        )
+    );
+    // This position will not be reached
 }
 
+#define DECLARE_UDF(NameSpace, Function) DECLARE_UDF_EXT(Function, NameSpace, Function)
+
+#define DECLARE_UDF_EXT(SQLName, NameSpace, Function) \
+    extern "C" { \
+        Datum SQLName(PG_FUNCTION_ARGS); \
+        PG_FUNCTION_INFO_V1(SQLName); \
+        Datum SQLName(PG_FUNCTION_ARGS) { \
+            MADFunction *f = sFunctions[kFunction_ ## SQLName]; \
+            if (f == NULL) \
+                reportMissingFunction(fcinfo); \
+            return call( (*f), fcinfo); \
+        } \
+    }
+    
 #include <madlib/modules/declarations.hpp>
 
 #undef DECLARE_UDF_EXT
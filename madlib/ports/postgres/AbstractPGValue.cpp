@@ -22,24 +22,60 @@ namespace ports {
 
 namespace postgres {
 
+/**
+ * Get the (detoasted) postgres array from a Datum and verify that we support
+ * it. Only one-dimensional arrays without NULLs are supported.
+ *
+ * An empty array literal ('{}') has no dimensions at all. It is accepted if
+ * inAllowEmpty is true, and arrayLength() has to be used for its size then.
+ */
+ArrayType *AbstractPGValue::DatumToArray(Datum inDatum, bool inAllowEmpty) {
+    ArrayType *pgArray = DatumGetArrayTypeP(inDatum);
+    
+    if (inAllowEmpty && ARR_NDIM(pgArray) == 0)
+        return pgArray;
+    
+    if (ARR_NDIM(pgArray) != 1)
+        throw std::invalid_argument("Multidimensional arrays not yet supported");
+    
+    if (ARR_HASNULL(pgArray))
+        throw std::invalid_argument("Arrays with NULLs not yet supported");
+    
+    return pgArray;
+}
+
+/**
+ * Number of elements of an array returned by DatumToArray()
+ */
+int AbstractPGValue::arrayLength(ArrayType *inArray) {
+    return ARR_NDIM(inArray) == 0 ? 0 : ARR_DIMS(inArray)[0];
+}
+
 /**
  * Convert postgres Datum into a ConcreteValue object.
  */
 AbstractValueSPtr AbstractPGValue::DatumToValue(bool inMemoryIsWritable,
     Oid inTypeID, Datum inDatum) const {
+    
+    bool isRowType = type_is_rowtype(inTypeID);
+    return DatumToValue(inMemoryIsWritable, inTypeID, isRowType,
+        !isRowType && type_is_array(inTypeID), inDatum);
+}
+
+/**
+ * Convert postgres Datum into a ConcreteValue object, given that the caller
+ * already knows whether the type is a rowtype or an array (e.g., from
+ * PGCallSiteCache). This avoids catalog lookups.
+ */
+AbstractValueSPtr AbstractPGValue::DatumToValue(bool inMemoryIsWritable,
+    Oid inTypeID, bool inIsRowType, bool inIsArray, Datum inDatum) const {
         
     // First check if datum is rowtype
-    if (type_is_rowtype(inTypeID)) {
+    if (inIsRowType) {
         HeapTupleHeader pgTuple = DatumGetHeapTupleHeader(inDatum);
         return AbstractValueSPtr(new PGValue<HeapTupleHeader>(pgTuple));
-    } else if (type_is_array(inTypeID)) {
-        ArrayType *pgArray = DatumGetArrayTypeP(inDatum);
-        
-        if (ARR_NDIM(pgArray) != 1)
-            throw std::invalid_argument("Multidimensional arrays not yet supported");
-        
-        if (ARR_HASNULL(pgArray))
-            throw std::invalid_argument("Arrays with NULLs not yet supported");
+    } else if (inIsArray) {
+        ArrayType *pgArray = DatumToArray(inDatum);
         
         switch (ARR_ELEMTYPE(pgArray)) {
             case FLOAT8OID: {
@@ -61,6 +97,24 @@ AbstractValueSPtr AbstractPGValue::DatumToValue(bool inMemoryIsWritable,
                         );
                 }
             }
+            
+            // Single-precision and integer arrays are always immutable. There
+            // is no aggregate transition state of these types. Elements are
+            // not converted, so no copy is made.
+            case FLOAT4OID: return AbstractValueSPtr(
+                new ConcreteValue<Array_const<float> >(
+                    Array_const<float>(
+                        MemHandleSPtr(new PGArrayHandle(pgArray)),
+                        boost::extents[ ARR_DIMS(pgArray)[0] ])
+                    )
+                );
+            case INT4OID: return AbstractValueSPtr(
+                new ConcreteValue<Array_const<int32_t> >(
+                    Array_const<int32_t>(
+                        MemHandleSPtr(new PGArrayHandle(pgArray)),
+                        boost::extents[ ARR_DIMS(pgArray)[0] ])
+                    )
+                );
         }
     }
 
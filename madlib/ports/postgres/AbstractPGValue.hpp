@@ -9,6 +9,10 @@
 
 #include <madlib/ports/postgres/postgres.hpp>
 
+extern "C" {
+    #include <utils/array.h>
+} // extern "C"
+
 namespace madlib {
 
 namespace ports {
@@ -19,6 +23,10 @@ class AbstractPGValue : public AbstractValue {
 protected:
     AbstractValueSPtr getValueByID(unsigned int inID) const = 0;
     AbstractValueSPtr DatumToValue(bool inMemoryIsWritable, Oid inTypeID, Datum inDatum) const;
+    AbstractValueSPtr DatumToValue(bool inMemoryIsWritable, Oid inTypeID,
+        bool inIsRowType, bool inIsArray, Datum inDatum) const;
+    static ArrayType *DatumToArray(Datum inDatum, bool inAllowEmpty = false);
+    static int arrayLength(ArrayType *inArray);
 };
 
 } // namespace postgres
@@ -67,32 +67,34 @@ ArrayType *PGAllocator::internalAllocateForArray(Oid inElementType,
  * C++'s defined behavior, we insist on proper stack unwinding and thus
  * surround any access of the database backend with PG_TRY()/PG_CATCH() macros.
  *
+ * The memory context has been resolved by PGInterface::allocator() already,
+ * so we allocate in it directly and never have to switch contexts. With
+ * PostgreSQL 9.5 and later, MemoryContextAllocExtended() can be asked to
+ * return NULL instead of raising an out-of-memory error. The only other error
+ * it raises is for invalid request sizes, which we check beforehand. We
+ * therefore do not need a PG_TRY() block at all in that case.
+ *
  * By default, memory allocation happens in AllocSetAlloc from utils/mmgr/aset.c.
  */
 void *PGAllocator::allocate(const uint32_t inSize) const throw(std::bad_alloc) {
     
-    void *ptr;
+    void *ptr = NULL;
+    MemoryContext context = mMemoryContext != NULL
+        ? mMemoryContext
+        : CurrentMemoryContext;
+
+#if PG_VERSION_NUM >= 90500
+    if (AllocSizeIsValid(inSize))
+        ptr = MemoryContextAllocExtended(context, inSize, MCXT_ALLOC_NO_OOM);
+    
+    if (ptr == NULL)
+        throw std::bad_alloc();
+#else
     bool errorOccurred = false;
-    MemoryContext oldContext = NULL;
-    MemoryContext aggContext = NULL;
  
     PG_TRY(); {
-        if (mContext == kAggregate) {
-            if (!AggCheckCallContext(mPGInterface->fcinfo, &aggContext))
-                throw std::logic_error("Internal error: Tried to allocate "
-                    "memory in aggregate context while not in aggregate");
-
-            oldContext = MemoryContextSwitchTo(aggContext);
-            ptr = palloc(inSize);
-            MemoryContextSwitchTo(oldContext);
-        } else {
-            ptr = palloc(inSize);
-        }
+        ptr = MemoryContextAlloc(context, inSize);
     } PG_CATCH(); {
-        // Probably not necessary but we clean up after ourselves
-        if (oldContext != NULL)
-            MemoryContextSwitchTo(oldContext);
-        
         errorOccurred = true;
     } PG_END_TRY();
 
@@ -107,11 +109,11 @@ void *PGAllocator::allocate(const uint32_t inSize) const throw(std::bad_alloc) {
      */
     if (errorOccurred)
         throw std::bad_alloc();
+#endif
     
     return ptr;
 }
 
-
 /**
  * @brief Allocate postgres memory in the default (function) memory context.
  *
@@ -140,7 +142,14 @@ void *PGAllocator::allocate(const uint32_t inSize, const std::nothrow_t&) const
     throw() {
     
     void *ptr = NULL;
-    
+
+#if PG_VERSION_NUM >= 90500
+    // See PGAllocator::allocate(const uint32_t). No error can be raised, so
+    // neither interrupts nor the error state have to be taken care of.
+    if (AllocSizeIsValid(inSize))
+        ptr = MemoryContextAllocExtended(CurrentMemoryContext, inSize,
+            MCXT_ALLOC_NO_OOM);
+#else
     /*
      * HOLD_INTERRUPTS() and RESUME_INTERRUPTS() only change the value of a
      * global variable but have no other side effects. In particular, they do
@@ -163,6 +172,7 @@ void *PGAllocator::allocate(const uint32_t inSize, const std::nothrow_t&) const
         ptr = NULL;
     } PG_END_TRY();
     RESUME_INTERRUPTS();
+#endif
     
     return ptr;
 }
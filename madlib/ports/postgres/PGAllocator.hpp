@@ -18,7 +18,8 @@ friend class PGInterface;
 public:
     PGAllocator()
         : mContext(kFunction),
-          mPGInterface(NULL)
+          mPGInterface(NULL),
+          mMemoryContext(NULL)
         { }
 
     MemHandleSPtr allocateArray(
@@ -34,15 +35,23 @@ public:
     void free(void *inPtr) const throw();
 
 protected:
-    PGAllocator(const PGInterface *const inPGInterface, Context inContext)
-        : mContext(inContext), mPGInterface(inPGInterface)
+    PGAllocator(const PGInterface *const inPGInterface, Context inContext,
+        MemoryContext inMemoryContext)
+        : mContext(inContext), mPGInterface(inPGInterface),
+          mMemoryContext(inMemoryContext)
         { }
 
     ArrayType *internalAllocateForArray(Oid inElementType,
         uint32_t inNumElements, size_t inElementSize) const;
         
     Context mContext;
-    const PGInterface *const mPGInterface;    
+    const PGInterface *const mPGInterface;
+    
+    /**
+     * Memory context to allocate in, already resolved by the PGInterface.
+     * NULL means the current memory context at the time of allocation.
+     */
+    const MemoryContext mMemoryContext;
 };
 
 } // namespace postgres
@@ -0,0 +1,273 @@
+/* ----------------------------------------------------------------------- *//**
+ *
+ * @file PGArena.cpp
+ *
+ * @brief Per-call arena for small C++ objects
+ *
+ *//* ----------------------------------------------------------------------- */
+
+#include <madlib/ports/postgres/PGArena.hpp>
+
+extern "C" {
+    #include <miscadmin.h>
+    #include <utils/memutils.h>
+} // extern "C"
+
+namespace madlib {
+
+namespace ports {
+
+namespace postgres {
+
+MemoryContext PGArena::sContext = NULL;
+bool PGArena::sCallbackRegistered = false;
+unsigned int PGArena::sDepth = 0;
+unsigned int PGArena::sNumBlocks = 0;
+PGArena::Block *PGArena::sBlocks = NULL;
+char *PGArena::sCurrent = NULL;
+char *PGArena::sLowest = NULL;
+char *PGArena::sHighest = NULL;
+PGArena::SavedDepth *PGArena::sSavedDepths = NULL;
+
+/**
+ * @brief Start using the arena. Calls may be nested.
+ *
+ * On first use, we register xactCallback() and subXactCallback(). If that
+ * fails, the arena is still usable; the depth is then only repaired by
+ * enclosing calls.
+ *
+ * @return The depth before entering, to be passed to leave()
+ */
+unsigned int PGArena::enter() throw() {
+    if (!sCallbackRegistered) {
+        HOLD_INTERRUPTS();
+        PG_TRY(); {
+            RegisterXactCallback(xactCallback, NULL);
+            RegisterSubXactCallback(subXactCallback, NULL);
+            sCallbackRegistered = true;
+        } PG_CATCH(); {
+            FlushErrorState();
+        } PG_END_TRY();
+        RESUME_INTERRUPTS();
+    }
+    
+    return sDepth++;
+}
+
+/**
+ * @brief Stop using the arena, and release all objects if this was the
+ *        outermost call
+ *
+ * @param inDepth The value returned by the matching enter(). Restoring it
+ *     (instead of decrementing) undoes any enter() whose leave() was skipped by
+ *     a longjmp in between.
+ */
+void PGArena::leave(unsigned int inDepth) throw() {
+    sDepth = inDepth;
+    if (sDepth == 0)
+        release();
+}
+
+/**
+ * @brief Release all objects in the arena
+ *
+ * If only one block was needed, we keep it for the next call. Otherwise, the
+ * whole memory context is reset. As in PGAllocator::free(), errors are
+ * ignored.
+ */
+void PGArena::release() throw() {
+    if (sBlocks == NULL)
+        return;
+    
+    if (sNumBlocks == 1) {
+        sCurrent = firstByte(sBlocks);
+        return;
+    }
+    
+    HOLD_INTERRUPTS();
+    PG_TRY(); {
+        MemoryContextReset(sContext);
+    } PG_CATCH(); {
+        FlushErrorState();
+    } PG_END_TRY();
+    RESUME_INTERRUPTS();
+    
+    sBlocks = NULL;
+    sCurrent = NULL;
+    sLowest = NULL;
+    sHighest = NULL;
+    sNumBlocks = 0;
+}
+
+/**
+ * @brief Reset the arena when a transaction ends
+ *
+ * No MADlib call can be active at that point, but the outermost call may have
+ * been left with a longjmp, skipping leave(). The saved depths of
+ * subtransactions are freed together with TopTransactionContext.
+ */
+void PGArena::xactCallback(XactEvent inEvent, void * /* inArg */) {
+    switch (inEvent) {
+        case XACT_EVENT_COMMIT:
+        case XACT_EVENT_ABORT:
+        case XACT_EVENT_PREPARE:
+            sSavedDepths = NULL;
+            sDepth = 0;
+            release();
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief Save the depth when a subtransaction starts, and restore it when the
+ *        subtransaction is aborted
+ *
+ * If the depth cannot be saved, the subtransaction is not tracked, and its
+ * abort only leaves the depth too high until the transaction ends.
+ */
+void PGArena::subXactCallback(SubXactEvent inEvent,
+    SubTransactionId inSubID, SubTransactionId /* inParentSubID */,
+    void * /* inArg */) {
+    
+    if (inEvent == SUBXACT_EVENT_START_SUB) {
+        SavedDepth *saved = NULL;
+        
+        HOLD_INTERRUPTS();
+        PG_TRY(); {
+            saved = static_cast<SavedDepth*>(
+                MemoryContextAlloc(TopTransactionContext, sizeof(SavedDepth)));
+        } PG_CATCH(); {
+            FlushErrorState();
+            saved = NULL;
+        } PG_END_TRY();
+        RESUME_INTERRUPTS();
+        
+        if (saved == NULL)
+            return;
+        
+        saved->next = sSavedDepths;
+        saved->subID = inSubID;
+        saved->depth = sDepth;
+        sSavedDepths = saved;
+        return;
+    }
+    
+    if (sSavedDepths == NULL || sSavedDepths->subID != inSubID)
+        return;
+    
+    SavedDepth *saved = sSavedDepths;
+    sSavedDepths = saved->next;
+    if (inEvent == SUBXACT_EVENT_ABORT_SUB) {
+        sDepth = saved->depth;
+        if (sDepth == 0)
+            release();
+    }
+    pfree(saved);
+}
+
+/**
+ * @brief Allocate a small object in the arena
+ *
+ * @return Pointer to the object, or NULL if the arena is not active, the
+ *     object is too large, or no block could be allocated. In the latter cases,
+ *     the caller has to fall back to regular allocation.
+ */
+void *PGArena::allocate(std::size_t inSize) throw() {
+    if (sDepth == 0 || inSize > kMaxObjectSize)
+        return NULL;
+    
+    std::size_t size = (inSize + kAlignment - 1) & ~(kAlignment - 1);
+    if (sBlocks == NULL || sCurrent + size > sBlocks->end) {
+        if (!newBlock())
+            return NULL;
+    }
+    
+    void *ptr = sCurrent;
+    sCurrent += size;
+    return ptr;
+}
+
+/**
+ * @brief Return whether a pointer was allocated by the arena
+ *
+ * This is called for every operator delete, so the common cases are decided
+ * by comparing addresses: Pointers outside the range spanned by all blocks,
+ * and pointers into the most recent block. Only otherwise do we have to walk
+ * the (at most kMaxNumBlocks) older blocks.
+ */
+bool PGArena::contains(const void *inPtr) throw() {
+    const char *ptr = static_cast<const char*>(inPtr);
+    
+    if (ptr <= sLowest || ptr >= sHighest)
+        return false;
+    if (ptr > reinterpret_cast<char*>(sBlocks) && ptr < sBlocks->end)
+        return true;
+    if (sNumBlocks == 1)
+        return false;
+    
+    for (Block *block = sBlocks->next; block != NULL; block = block->next)
+        if (ptr > reinterpret_cast<char*>(block) && ptr < block->end)
+            return true;
+    
+    return false;
+}
+
+/**
+ * @brief Return the first suitably aligned byte after the block header
+ */
+char *PGArena::firstByte(Block *inBlock) throw() {
+    uintptr_t begin = reinterpret_cast<uintptr_t>(inBlock + 1);
+    return reinterpret_cast<char*>(
+        (begin + kAlignment - 1) & ~static_cast<uintptr_t>(kAlignment - 1));
+}
+
+/**
+ * @brief Allocate a new block in the arena's memory context
+ *
+ * We hold back interrupts and flush the error state, for the same reasons as
+ * in PGAllocator::allocate(const uint32_t, const std::nothrow_t&).
+ */
+bool PGArena::newBlock() throw() {
+    if (sNumBlocks >= kMaxNumBlocks)
+        return false;
+    
+    Block *block = NULL;
+    
+    HOLD_INTERRUPTS();
+    PG_TRY(); {
+        if (sContext == NULL)
+            sContext = AllocSetContextCreate(TopMemoryContext,
+                "MADlib arena",
+                ALLOCSET_DEFAULT_MINSIZE,
+                ALLOCSET_DEFAULT_INITSIZE,
+                ALLOCSET_DEFAULT_MAXSIZE);
+        
+        block = static_cast<Block*>(MemoryContextAlloc(sContext, kBlockSize));
+    } PG_CATCH(); {
+        FlushErrorState();
+        block = NULL;
+    } PG_END_TRY();
+    RESUME_INTERRUPTS();
+    
+    if (block == NULL)
+        return false;
+    
+    block->next = sBlocks;
+    block->end = reinterpret_cast<char*>(block) + kBlockSize;
+    sBlocks = block;
+    sCurrent = firstByte(block);
+    if (sLowest == NULL || reinterpret_cast<char*>(block) < sLowest)
+        sLowest = reinterpret_cast<char*>(block);
+    if (block->end > sHighest)
+        sHighest = block->end;
+    sNumBlocks++;
+    return true;
+}
+
+} // namespace postgres
+
+} // namespace ports
+
+} // namespace madlib
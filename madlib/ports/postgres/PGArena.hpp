@@ -0,0 +1,108 @@
+/* ----------------------------------------------------------------------- *//**
+ *
+ * @file PGArena.hpp
+ *
+ * @brief Header file for the per-call arena for small C++ objects
+ *
+ *//* ----------------------------------------------------------------------- */
+
+#ifndef MADLIB_PGARENA_HPP
+#define MADLIB_PGARENA_HPP
+
+#include <madlib/ports/postgres/postgres.hpp>
+
+extern "C" {
+    #include <access/xact.h>
+} // extern "C"
+
+namespace madlib {
+
+namespace ports {
+
+namespace postgres {
+
+/**
+ * @brief Bump allocator for small objects that only live during one call of
+ *        a MADlib function
+ *
+ * Every call into a MADlib function creates a number of small, short-lived
+ * C++ objects (shared_ptr control blocks, AnyValue and ConcreteValue objects,
+ * memory handles, etc.). Allocating each of them with palloc() inside
+ * PG_TRY() is relatively expensive. Instead, while a call is active (between
+ * enter() and leave()), operator new carves small objects out of blocks taken
+ * from a dedicated memory context. operator delete does nothing for these
+ * objects, and all of them are released at once when the outermost call
+ * leaves the arena.
+ *
+ * Consequently, no object allocated with operator new during a call may
+ * outlive the call. In particular, anything that is returned to the database
+ * must be allocated with palloc() or PGAllocator.
+ *
+ * An error raised by the backend (ereport(ERROR)) unwinds the stack with
+ * longjmp(), so leave() may be skipped. Callers therefore pass the depth
+ * returned by enter() to leave(), which restores it. This repairs the depth
+ * whenever an enclosing call returns. The error may also be caught without
+ * any enclosing MADlib call, by aborting a subtransaction (e.g., in a PL/pgSQL
+ * EXCEPTION block, or when PL/Python catches an error of plpy.execute()). We
+ * therefore save the depth when a subtransaction starts and restore it when
+ * the subtransaction is aborted. Finally, the arena is reset when the
+ * transaction ends, at which point no call can be active.
+ */
+class PGArena {
+public:
+    static unsigned int enter() throw();
+    static void leave(unsigned int inDepth) throw();
+    
+    static void *allocate(std::size_t inSize) throw();
+    static bool contains(const void *inPtr) throw();
+    
+private:
+    struct Block {
+        Block *next;
+        char *end;
+    };
+    
+    /**
+     * Depth at the start of a subtransaction, allocated in
+     * TopTransactionContext
+     */
+    struct SavedDepth {
+        SavedDepth *next;
+        SubTransactionId subID;
+        unsigned int depth;
+    };
+    
+    static char *firstByte(Block *inBlock) throw();
+    static bool newBlock() throw();
+    static void release() throw();
+    static void xactCallback(XactEvent inEvent, void *inArg);
+    static void subXactCallback(SubXactEvent inEvent,
+        SubTransactionId inSubID, SubTransactionId inParentSubID,
+        void *inArg);
+    
+    /**
+     * Objects larger than this are not allocated in the arena
+     */
+    static const std::size_t kMaxObjectSize = 256;
+    static const std::size_t kBlockSize = 16384;
+    static const unsigned int kMaxNumBlocks = 64;
+    static const std::size_t kAlignment = 16;
+    
+    static MemoryContext sContext;
+    static bool sCallbackRegistered;
+    static unsigned int sDepth;
+    static unsigned int sNumBlocks;
+    static Block *sBlocks;      //!< Most recent block first
+    static char *sCurrent;      //!< Next free byte in the most recent block
+    static char *sLowest;       //!< Lowest address of any block
+    static char *sHighest;      //!< Highest end address of any block
+    static SavedDepth *sSavedDepths; //!< Innermost subtransaction first
+};
+
+} // namespace postgres
+
+} // namespace ports
+
+} // namespace madlib
+
+#endif
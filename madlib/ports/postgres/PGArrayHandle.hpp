@@ -2,6 +2,7 @@
 #define MADLIB_PGARRAYHANDLE_HPP
 
 #include <madlib/ports/postgres/postgres.hpp>
+#include <madlib/ports/postgres/PGAllocator.hpp>
 
 extern "C" {
     #include "utils/array.h"
@@ -27,10 +28,11 @@ public:
     }
     
     virtual MemHandleSPtr clone() const {
-        // Use operator new to allocate memory (this will allocate memory in
-        // the default postgres context)
+        // Allocate memory in the default postgres context. We must not use
+        // operator new here, because small objects allocated with operator
+        // new do not survive the current call (see PGArena).
         ArrayType   *newArray =
-            static_cast<ArrayType *>( ::operator new(VARSIZE(mArray)) );
+            static_cast<ArrayType *>( PGAllocator().allocate(VARSIZE(mArray)) );
         std::memcpy(newArray, mArray, VARSIZE(mArray));
         return MemHandleSPtr( new PGArrayHandle(newArray) );
     }
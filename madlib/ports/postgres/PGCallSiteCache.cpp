@@ -0,0 +1,231 @@
+/* ----------------------------------------------------------------------- *//**
+ *
+ * @file PGCallSiteCache.cpp
+ *
+ * @brief Per-call-site cache of type information
+ *
+ *//* ----------------------------------------------------------------------- */
+
+#include <madlib/ports/postgres/compatibility.hpp>
+#include <madlib/ports/postgres/PGCallSiteCache.hpp>
+
+#include <cstring>
+#include <stdexcept>
+
+extern "C" {
+    #include <utils/lsyscache.h>
+} // extern "C"
+
+namespace madlib {
+
+namespace ports {
+
+namespace postgres {
+
+/**
+ * @brief Return the cache for the call site of fcinfo, and create it if
+ *        necessary
+ *
+ * Argument types are resolved right away. The result type is only resolved
+ * on demand by resolveResult(), because not all callers need it.
+ *
+ * As in PGAllocator::allocate(), all calls into the backend are guarded by
+ * PG_TRY(), and errors are converted into C++ exceptions.
+ */
+PGCallSiteCache *PGCallSiteCache::get(const FunctionCallInfo fcinfo) {
+    if (fcinfo == NULL || fcinfo->flinfo == NULL)
+        throw std::invalid_argument("fcinfo is NULL");
+    
+    if (fcinfo->flinfo->fn_extra != NULL)
+        return static_cast<PGCallSiteCache*>(fcinfo->flinfo->fn_extra);
+    
+    PGCallSiteCache *cache = NULL;
+    bool errorOccurred = false;
+    
+    PG_TRY(); {
+        cache = static_cast<PGCallSiteCache*>(
+            MemoryContextAllocZero(fcinfo->flinfo->fn_mcxt,
+                sizeof(PGCallSiteCache)));
+        cache->memoryContext = fcinfo->flinfo->fn_mcxt;
+        cache->numArgs = PG_NARGS();
+        cache->args = static_cast<Argument*>(
+            MemoryContextAllocZero(fcinfo->flinfo->fn_mcxt,
+                Max(cache->numArgs, 1) * sizeof(Argument)));
+        
+        for (int i = 0; i < cache->numArgs; i++) {
+            Argument &arg = cache->args[i];
+            
+            arg.typeID = get_fn_expr_argtype(fcinfo->flinfo, i);
+            if (arg.typeID == InvalidOid)
+                continue;
+            
+            arg.isRowType = type_is_rowtype(arg.typeID);
+            arg.elementTypeID = arg.isRowType
+                ? InvalidOid
+                : get_element_type(arg.typeID);
+        }
+    } PG_CATCH(); {
+        errorOccurred = true;
+    } PG_END_TRY();
+    
+    if (errorOccurred)
+        throw std::runtime_error("Error while looking up argument types");
+    
+    fcinfo->flinfo->fn_extra = cache;
+    return cache;
+}
+
+/**
+ * @brief Return the type information of an argument
+ */
+const PGCallSiteCache::Argument &PGCallSiteCache::argument(unsigned int inID)
+    const {
+    
+    if (inID >= static_cast<unsigned int>(numArgs))
+        throw std::out_of_range("Access behind end of argument list");
+    
+    if (args[inID].typeID == InvalidOid)
+        throw std::invalid_argument("Cannot determine argument type");
+    
+    return args[inID];
+}
+
+/**
+ * @brief Resolve the result type of the call site, unless already done
+ *
+ * get_call_result_type() is tagged as expensive in funcapi.c. The tuple
+ * descriptor it returns is allocated in the current memory context, so we
+ * keep a copy in fn_mcxt.
+ */
+void PGCallSiteCache::resolveResult(const FunctionCallInfo fcinfo) {
+    if (resultIsResolved)
+        return;
+    
+    bool errorOccurred = false;
+    MemoryContext oldContext = NULL;
+    
+    PG_TRY(); {
+        TupleDesc tupleDesc = NULL;
+        
+        resultFuncClass = get_call_result_type(fcinfo, &resultTypeID,
+            &tupleDesc);
+        resultElementTypeID = resultFuncClass == TYPEFUNC_SCALAR
+            ? get_element_type(resultTypeID)
+            : InvalidOid;
+        resultIsFixedLength = resultFuncClass == TYPEFUNC_SCALAR
+            && get_typlen(resultTypeID) != -1;
+        
+        if (tupleDesc != NULL) {
+            oldContext = MemoryContextSwitchTo(fcinfo->flinfo->fn_mcxt);
+            resultTupleDesc = BlessTupleDesc(CreateTupleDescCopy(tupleDesc));
+            MemoryContextSwitchTo(oldContext);
+            oldContext = NULL;
+        }
+    } PG_CATCH(); {
+        if (oldContext != NULL)
+            MemoryContextSwitchTo(oldContext);
+        
+        errorOccurred = true;
+    } PG_END_TRY();
+    
+    if (errorOccurred)
+        throw std::runtime_error("Error while looking up result type");
+    
+    resultIsResolved = true;
+}
+
+/**
+ * @brief Return the expanded form of a varlena argument, detoasting it only if
+ *        it differs from the argument of the previous call
+ *
+ * Immutable arguments are often the same for all rows, e.g., the previous
+ * state of an iterative algorithm that is passed to an aggregate as a
+ * sub-query. Without this cache, a compressed or out-of-line value would be
+ * fetched and expanded for every row.
+ *
+ * The cache key is a copy of the value as passed. For a value stored out of
+ * line on disk, this is the TOAST pointer, which identifies the value. An
+ * inline compressed value is at most a few kilobytes, so comparing it is still
+ * much cheaper than decompressing it. All other values are returned as they
+ * are, and the caller detoasts them without the cache (DatumGetArrayTypeP()).
+ * In particular, this applies to indirect and expanded pointers (PostgreSQL
+ * 9.4 and later): They only contain a memory address, which may be reused for
+ * a different value, so they cannot serve as a cache key.
+ *
+ * Arguments that differ from row to row (e.g., the independent variables)
+ * would only pay for the copy and comparison. We therefore stop caching an
+ * argument if it changes before it has been found in the cache once, and
+ * return it as is from then on.
+ *
+ * The expanded value is freed when the argument changes. Callers must hence
+ * neither modify it nor return it.
+ */
+Datum PGCallSiteCache::detoast(unsigned int inID, Datum inDatum) {
+    struct varlena *raw
+        = reinterpret_cast<struct varlena*>(DatumGetPointer(inDatum));
+    
+    if (!VARATT_IS_EXTERNAL_ONDISK(raw) && !VARATT_IS_COMPRESSED(raw))
+        return inDatum;
+    
+    if (inID >= static_cast<unsigned int>(numArgs))
+        throw std::out_of_range("Access behind end of argument list");
+    
+    Argument &arg = args[inID];
+    if (arg.isUncacheable)
+        return inDatum;
+    
+    Size rawSize = VARSIZE_ANY(raw);
+    if (arg.rawValue != NULL && VARSIZE_ANY(arg.rawValue) == rawSize &&
+        std::memcmp(arg.rawValue, raw, rawSize) == 0) {
+        
+        arg.cacheHit = true;
+        return PointerGetDatum(arg.detoastedValue);
+    }
+    
+    bool cacheValue = arg.rawValue == NULL || arg.cacheHit;
+    bool errorOccurred = false;
+    MemoryContext oldContext = NULL;
+    
+    PG_TRY(); {
+        if (arg.rawValue != NULL) {
+            pfree(arg.rawValue);
+            pfree(arg.detoastedValue);
+            arg.rawValue = NULL;
+            arg.detoastedValue = NULL;
+        }
+        
+        if (cacheValue) {
+            oldContext = MemoryContextSwitchTo(memoryContext);
+            struct varlena *detoasted = pg_detoast_datum(raw);
+            struct varlena *rawCopy = static_cast<struct varlena*>(
+                palloc(rawSize));
+            std::memcpy(rawCopy, raw, rawSize);
+            MemoryContextSwitchTo(oldContext);
+            oldContext = NULL;
+            
+            arg.detoastedValue = detoasted;
+            arg.rawValue = rawCopy;
+        }
+    } PG_CATCH(); {
+        if (oldContext != NULL)
+            MemoryContextSwitchTo(oldContext);
+        
+        errorOccurred = true;
+    } PG_END_TRY();
+    
+    if (errorOccurred)
+        throw std::runtime_error("Error while detoasting argument");
+    
+    if (!cacheValue) {
+        arg.isUncacheable = true;
+        return inDatum;
+    }
+    
+    return PointerGetDatum(arg.detoastedValue);
+}
+
+} // namespace postgres
+
+} // namespace ports
+
+} // namespace madlib
@@ -0,0 +1,81 @@
+/* ----------------------------------------------------------------------- *//**
+ *
+ * @file PGCallSiteCache.hpp
+ *
+ * @brief Header file for the per-call-site cache of type information
+ *
+ *//* ----------------------------------------------------------------------- */
+
+#ifndef MADLIB_PGCALLSITECACHE_HPP
+#define MADLIB_PGCALLSITECACHE_HPP
+
+#include <madlib/ports/postgres/postgres.hpp>
+
+extern "C" {
+    #include <fmgr.h>
+    #include <funcapi.h>        // for TypeFuncClass
+    #include <access/tupdesc.h> // for TupleDesc
+} // extern "C"
+
+namespace madlib {
+
+namespace ports {
+
+namespace postgres {
+
+/**
+ * @brief Type information about the arguments and the result of a function
+ *        call site
+ *
+ * The types of the arguments and of the result do not change between calls
+ * from the same call site (i.e., for the same FmgrInfo). In particular, an
+ * aggregate calls its transition function with the same FmgrInfo for every
+ * row. We therefore look up all type information only once and keep it in
+ * <tt>fcinfo->flinfo->fn_extra</tt>, allocated in
+ * <tt>fcinfo->flinfo->fn_mcxt</tt>.
+ *
+ * In addition, we keep the expanded value of each toasted argument, so that
+ * an argument that is the same for many calls is only detoasted once. See
+ * detoast().
+ *
+ * PGCallSiteCache is a POD type because it lives in PostgreSQL memory and is
+ * never destructed.
+ */
+struct PGCallSiteCache {
+    struct Argument {
+        Oid typeID;
+        Oid elementTypeID;  //!< InvalidOid if the argument is not an array
+        bool isRowType;
+        
+        struct varlena *rawValue;       //!< Copy of the last toasted value
+        struct varlena *detoastedValue; //!< Expanded form of rawValue
+        bool cacheHit;      //!< rawValue was found in the cache at least once
+        bool isUncacheable; //!< Argument changed before any cache hit
+    };
+    
+    static PGCallSiteCache *get(const FunctionCallInfo fcinfo);
+    
+    const Argument &argument(unsigned int inID) const;
+    void resolveResult(const FunctionCallInfo fcinfo);
+    Datum detoast(unsigned int inID, Datum inDatum);
+    
+    MemoryContext memoryContext;  //!< fn_mcxt of the call site
+    int numArgs;
+    Argument *args;
+    
+    // The following fields are only valid if resultIsResolved is true
+    bool resultIsResolved;
+    TypeFuncClass resultFuncClass;
+    Oid resultTypeID;
+    Oid resultElementTypeID;
+    bool resultIsFixedLength;   //!< Result cannot point to an argument
+    TupleDesc resultTupleDesc;  //!< Blessed copy, owned by the cache
+};
+
+} // namespace postgres
+
+} // namespace ports
+
+} // namespace madlib
+
+#endif
@@ -1,3 +1,4 @@
+#include <madlib/ports/postgres/compatibility.hpp>
 #include <madlib/ports/postgres/PGInterface.hpp>
 #include <madlib/ports/postgres/PGAllocator.hpp>
 
@@ -7,10 +8,41 @@ namespace ports {
 
 namespace postgres {
 
-inline AllocatorSPtr PGInterface::allocator(
+/**
+ * @brief Return an allocator for the given memory context
+ *
+ * Allocators are created only once per function call. For
+ * AbstractAllocator::kAggregate, the aggregate memory context is resolved
+ * here, so that PGAllocator::allocate() does not have to look it up again for
+ * every single allocation.
+ */
+AllocatorSPtr PGInterface::allocator(
     AbstractAllocator::Context inMemContext) {
     
-    return AllocatorSPtr(new PGAllocator(this, inMemContext));
+    AllocatorSPtr &allocator = mAllocators[
+        inMemContext == AbstractAllocator::kAggregate ? 1 : 0];
+    
+    if (!allocator) {
+        allocator.reset(inMemContext == AbstractAllocator::kAggregate
+            ? new PGAllocator(this, inMemContext, aggregateContext())
+            : new PGAllocator(this, inMemContext, NULL));
+    }
+    return allocator;
+}
+
+/**
+ * @brief Return the memory context of the aggregate we are called from
+ *
+ * AggCheckCallContext() does not call into the error-handling mechanism of
+ * the backend, so no PG_TRY() block is needed here.
+ */
+MemoryContext PGInterface::aggregateContext() {
+    if (mAggregateContext == NULL &&
+        !AggCheckCallContext(fcinfo, &mAggregateContext))
+        throw std::logic_error("Internal error: Tried to allocate "
+            "memory in aggregate context while not in aggregate");
+    
+    return mAggregateContext;
 }
 
 } // namespace postgres
@@ -19,17 +19,30 @@ class PGInterface : public AbstractDBInterface {
 
 public:
     PGInterface(const FunctionCallInfo inFCinfo)
-        : fcinfo(inFCinfo) { }
+        : fcinfo(inFCinfo), mAggregateContext(NULL) { }
     
     AllocatorSPtr allocator(
         AbstractAllocator::Context inMemContext = AbstractAllocator::kFunction);
     
 private:
+    MemoryContext aggregateContext();
+
     /**
      * The name is chosen so that PostgreSQL macros like PG_NARGS can be
      * used.
      */
     const FunctionCallInfo fcinfo;
+    
+    /**
+     * Aggregate memory context, resolved by the first call to
+     * aggregateContext()
+     */
+    MemoryContext mAggregateContext;
+    
+    /**
+     * Allocators already handed out, one for each AbstractAllocator::Context
+     */
+    AllocatorSPtr mAllocators[2];
 };
 
 } // namespace postgres
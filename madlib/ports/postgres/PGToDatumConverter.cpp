@@ -8,6 +8,7 @@
 
 #include <madlib/ports/postgres/PGToDatumConverter.hpp>
 #include <madlib/ports/postgres/PGArrayHandle.hpp>
+#include <madlib/ports/postgres/PGCallSiteCache.hpp>
 
 extern "C" {
     #include <utils/array.h>
@@ -24,13 +25,23 @@ namespace ports {
 
 namespace postgres {
 
+/**
+ * @internal The result type and tuple descriptor are looked up only once per
+ *     call site and then kept in PGCallSiteCache. The cached tuple descriptor
+ *     must not be released.
+ */
 PGToDatumConverter::PGToDatumConverter(const FunctionCallInfo inFCInfo,
     const AbstractValue &inValue)
-    : ValueConverter<Datum>(inValue), mTupleDesc(NULL), mTypeID(0) {
+    : ValueConverter<Datum>(inValue), mTupleDesc(NULL), mOwnsTupleDesc(false),
+      mTypeID(0), mElementTypeID(InvalidOid) {
     
-    // FIXME: (Or Note:) get_call_result_type is tagged as expensive in funcapi.c
-    TypeFuncClass funcClass = get_call_result_type(inFCInfo, &mTypeID,
-        &mTupleDesc);
+    PGCallSiteCache *cache = PGCallSiteCache::get(inFCInfo);
+    cache->resolveResult(inFCInfo);
+    
+    TypeFuncClass funcClass = cache->resultFuncClass;
+    mTypeID = cache->resultTypeID;
+    mElementTypeID = cache->resultElementTypeID;
+    mTupleDesc = cache->resultTupleDesc;
     
     if (!mValue.isCompound() && funcClass == TYPEFUNC_COMPOSITE)
         throw std::logic_error("Internal function does not provide compound "
@@ -43,7 +54,8 @@ PGToDatumConverter::PGToDatumConverter(const FunctionCallInfo inFCInfo,
 
 PGToDatumConverter::PGToDatumConverter(Oid inTypeID,
     const AbstractValue &inValue)
-    : ValueConverter<Datum>(inValue), mTupleDesc(NULL), mTypeID(inTypeID) {
+    : ValueConverter<Datum>(inValue), mTupleDesc(NULL), mOwnsTupleDesc(true),
+      mTypeID(inTypeID), mElementTypeID(InvalidOid) {
     
     if (type_is_rowtype(inTypeID)) {
         if (!mValue.isCompound())
@@ -61,6 +73,16 @@ PGToDatumConverter::PGToDatumConverter(Oid inTypeID,
     }
 }
 
+/**
+ * @brief Return the element type if the SQL type is an array, and InvalidOid
+ *        otherwise
+ */
+Oid PGToDatumConverter::elementTypeID() const {
+    return mElementTypeID != InvalidOid
+        ? mElementTypeID
+        : get_element_type(mTypeID);
+}
+
 void PGToDatumConverter::convert(const AnyValueVector &inRecord) {
     if (!mValue.isCompound())
         throw std::logic_error("Internal MADlib error, got internal compound "
@@ -124,25 +146,39 @@ void PGToDatumConverter::convert(const int32_t &inValue) {
     }
 }
 
-void PGToDatumConverter::convert(const Array<double> &inValue) {
-    Oid elementTypeID = get_element_type(mTypeID);
+/**
+ * @brief Convert a contiguous block of doubles to a PostgreSQL array
+ *
+ * If the memory is already the data section of a PostgreSQL array of exactly
+ * the same length (e.g., because it was allocated with
+ * AbstractDBInterface::allocator()), the array is returned as is. Otherwise,
+ * a new array is constructed and the values are copied.
+ */
+void PGToDatumConverter::convertDoubleArray(MemHandleSPtr inHandle,
+    const double *inData, uint32_t inNumElements) {
+    
+    Oid elementTypeID = this->elementTypeID();
     switch (elementTypeID) {
         case FLOAT8OID: {
             shared_ptr<PGArrayHandle> arrayHandle
-                = dynamic_pointer_cast<PGArrayHandle>(inValue.memoryHandle());
+                = dynamic_pointer_cast<PGArrayHandle>(inHandle);
             
-            if (arrayHandle) {
+            if (arrayHandle &&
+                ARR_ELEMTYPE(arrayHandle->array()) == FLOAT8OID &&
+                arrayHandle->ptr() == inData &&
+                ARR_DIMS(arrayHandle->array())[0] == int(inNumElements)) {
+                
                 mConvertedValue = PointerGetDatum(arrayHandle->array());
             } else {
-                // If the Array does not use an PostgreSQL array
-                // as its storage, we have to create a new one and copy the values.
+                // If the memory is not backed by a PostgreSQL array, we have
+                // to create a new one and copy the values.
                 mConvertedValue =
                     PointerGetDatum(
                         construct_array(
                             reinterpret_cast<Datum*>(
-                                const_cast<double*>(inValue.data())
+                                const_cast<double*>(inData)
                             ),
-                            inValue.num_elements(),
+                            inNumElements,
                             FLOAT8OID, sizeof(double), true, 'd'
                         )
                     );
@@ -155,21 +191,29 @@ void PGToDatumConverter::convert(const Array<double> &inValue) {
     }
 }
 
+void PGToDatumConverter::convert(const Array<double> &inValue) {
+    convertDoubleArray(inValue.memoryHandle(), inValue.data(),
+        inValue.num_elements());
+}
+
 void PGToDatumConverter::convert(const DoubleCol &inValue) {
-    Oid elementTypeID = get_element_type(mTypeID);
-    switch (elementTypeID) {
-        // FIXME: We copy memory here!
-        case FLOAT8OID:
-            mConvertedValue = PointerGetDatum(
-                construct_array(
-                    reinterpret_cast<Datum*>(const_cast<double*>(inValue.memptr())),
-                    inValue.n_elem, FLOAT8OID, sizeof(double), true, 'd')
-            ); break;
-        case InvalidOid: throw std::logic_error(
-            "Internal return type does not match SQL declaration");
-        default: throw std::logic_error(
-            "Internal element type of returned array does not match SQL declaration");
-    }
+    convertDoubleArray(inValue.memoryHandle(), inValue.memptr(),
+        inValue.n_elem);
+}
+
+void PGToDatumConverter::convert(const DoubleRow &inValue) {
+    convertDoubleArray(inValue.memoryHandle(), inValue.memptr(),
+        inValue.n_elem);
+}
+
+/**
+ * @brief Convert a matrix to a one-dimensional PostgreSQL array
+ *
+ * The array contains the matrix in column-major order.
+ */
+void PGToDatumConverter::convert(const DoubleMat &inValue) {
+    convertDoubleArray(inValue.memoryHandle(), inValue.memptr(),
+        inValue.n_elem);
 }
 
 } // namespace postgres
@@ -33,7 +33,7 @@ public:
     PGToDatumConverter(Oid inTypeID, const AbstractValue &inValue);
     
     ~PGToDatumConverter() {
-        if (mTupleDesc != NULL)
+        if (mTupleDesc != NULL && mOwnsTupleDesc)
             ReleaseTupleDesc(mTupleDesc);
     }
     
@@ -43,12 +43,25 @@ public:
     
     void convert(const Array<double> &inValue);
     void convert(const DoubleCol &inValue);
+    void convert(const DoubleRow &inValue);
+    void convert(const DoubleMat &inValue);
     
     void convert(const AnyValueVector &inRecord);
     
 protected:
+    Oid elementTypeID() const;
+    void convertDoubleArray(MemHandleSPtr inHandle, const double *inData,
+        uint32_t inNumElements);
+
     TupleDesc mTupleDesc;
+    bool mOwnsTupleDesc;
     Oid mTypeID;
+    
+    /**
+     * Element type if known in advance (from PGCallSiteCache), InvalidOid
+     * otherwise
+     */
+    Oid mElementTypeID;
 };
 
 } // namespace postgres
@@ -8,10 +8,13 @@
 
 #include <madlib/ports/postgres/compatibility.hpp>
 #include <madlib/ports/postgres/PGValue.hpp>
+#include <madlib/ports/postgres/PGArrayHandle.hpp>
+#include <madlib/ports/postgres/PGCallSiteCache.hpp>
 
 #include <stdexcept>
 
 extern "C" {
+    #include <catalog/pg_type.h>
     #include <utils/typcache.h>
     #include <executor/executor.h>
 }
@@ -35,9 +38,8 @@ AbstractValueSPtr PGValue<FunctionCallInfo>::getValueByID(unsigned int inID) con
     if (PG_ARGISNULL(inID))
         return AbstractValueSPtr(new AnyValue(Null()));
     
-    Oid typeID = get_fn_expr_argtype(fcinfo->flinfo, inID);
-    if (typeID == InvalidOid)
-        throw std::invalid_argument("Cannot determine argument type");
+    const PGCallSiteCache::Argument &argInfo
+        = PGCallSiteCache::get(fcinfo)->argument(inID);
 
     // If we are called as an aggregate function, the first argument is the
     // transition state. In that case, we are free to modify the data.
@@ -47,7 +49,10 @@ AbstractValueSPtr PGValue<FunctionCallInfo>::getValueByID(unsigned int inID) con
     // http://www.postgresql.org/docs/current/static/xfunc-c.html#XFUNC-C-BASETYPE
     bool writable = (inID == 0 && AggCheckCallContext(fcinfo, NULL));
 
-    AbstractValueSPtr value = DatumToValue(writable, typeID, PG_GETARG_DATUM(inID));
+    bool isArray = argInfo.elementTypeID != InvalidOid;
+    AbstractValueSPtr value = DatumToValue(writable, argInfo.typeID,
+        argInfo.isRowType, isArray,
+        isArray ? getArrayDatumByID(inID) : PG_GETARG_DATUM(inID));
     if (!value)
         throw std::invalid_argument(
             "Internal argument type does not match SQL argument type");
@@ -55,6 +60,166 @@ AbstractValueSPtr PGValue<FunctionCallInfo>::getValueByID(unsigned int inID) con
     return value;
 }
 
+/**
+ * @brief Return the (cached) SQL type information of a function argument
+ *
+ * This is the common part of all getAsByID() functions. In contrast to
+ * getValueByID(), it is an error if the argument is NULL.
+ */
+const PGCallSiteCache::Argument &PGValue<FunctionCallInfo>::getArgumentByID(
+    unsigned int inID) const {
+    
+    if (fcinfo == NULL)
+        throw std::invalid_argument("fcinfo is NULL");
+
+    if (inID >= size_t(PG_NARGS()))
+        throw std::out_of_range("Access behind end of argument list");
+
+    if (PG_ARGISNULL(inID))
+        throw std::logic_error("Internal type conversion error");
+    
+    return PGCallSiteCache::get(fcinfo)->argument(inID);
+}
+
+/**
+ * @brief Return the datum of an array argument
+ *
+ * Functions are often called once per row with arguments that are the same
+ * for every row, e.g., the non-state arguments of an aggregate transition
+ * function, or the coefficients passed to a prediction function. For these,
+ * we use PGCallSiteCache::detoast() so that a toasted value is only expanded
+ * once. The cached value must never be handed back to the backend. By
+ * convention, transition functions return the state or a new value, but
+ * never another argument. Other functions can only return an argument if the
+ * result is of variable length. (Fixed-length results such as float8 are
+ * always copied, even where they are passed by reference, as on 32-bit
+ * platforms.)
+ */
+Datum PGValue<FunctionCallInfo>::getArrayDatumByID(unsigned int inID) const {
+    Datum datum = PG_GETARG_DATUM(inID);
+    PGCallSiteCache *cache = PGCallSiteCache::get(fcinfo);
+    
+    if (AggCheckCallContext(fcinfo, NULL)) {
+        if (inID == 0)
+            return datum;
+    } else {
+        cache->resolveResult(fcinfo);
+        if (!cache->resultIsFixedLength)
+            return datum;
+    }
+    
+    return cache->detoast(inID, datum);
+}
+
+/**
+ * @brief Return a function argument that is an array with the given element
+ *     type
+ *
+ * @param inAllowEmpty Whether to accept an empty array, which has no
+ *     dimensions (see DatumToArray())
+ */
+ArrayType *PGValue<FunctionCallInfo>::getArrayByID(unsigned int inID,
+    Oid inElementTypeID, bool inAllowEmpty) const {
+    
+    if (getArgumentByID(inID).elementTypeID != inElementTypeID)
+        throw std::invalid_argument(
+            "Internal argument type does not match SQL argument type");
+    
+    return DatumToArray(getArrayDatumByID(inID), inAllowEmpty);
+}
+
+/**
+ * @internal The following conversions only allow lossless conversion, just like
+ *     the conversions defined in ConcreteValue_impl.hpp.
+ */
+bool PGValue<FunctionCallInfo>::getAsByID(unsigned int inID, bool*) const {
+    switch (getArgumentByID(inID).typeID) {
+        case BOOLOID: return DatumGetBool(PG_GETARG_DATUM(inID));
+    }
+    throw std::invalid_argument(
+        "Internal argument type does not match SQL argument type");
+}
+
+int32_t PGValue<FunctionCallInfo>::getAsByID(unsigned int inID, int32_t*) const {
+    switch (getArgumentByID(inID).typeID) {
+        case INT4OID: return DatumGetInt32(PG_GETARG_DATUM(inID));
+        case INT2OID: return DatumGetInt16(PG_GETARG_DATUM(inID));
+        case BOOLOID: return DatumGetBool(PG_GETARG_DATUM(inID));
+    }
+    throw std::invalid_argument(
+        "Internal argument type does not match SQL argument type");
+}
+
+int64_t PGValue<FunctionCallInfo>::getAsByID(unsigned int inID, int64_t*) const {
+    switch (getArgumentByID(inID).typeID) {
+        case INT8OID: return DatumGetInt64(PG_GETARG_DATUM(inID));
+        case INT4OID: return DatumGetInt32(PG_GETARG_DATUM(inID));
+        case INT2OID: return DatumGetInt16(PG_GETARG_DATUM(inID));
+        case BOOLOID: return DatumGetBool(PG_GETARG_DATUM(inID));
+    }
+    throw std::invalid_argument(
+        "Internal argument type does not match SQL argument type");
+}
+
+double PGValue<FunctionCallInfo>::getAsByID(unsigned int inID, double*) const {
+    switch (getArgumentByID(inID).typeID) {
+        case FLOAT8OID: return DatumGetFloat8(PG_GETARG_DATUM(inID));
+        case FLOAT4OID: return DatumGetFloat4(PG_GETARG_DATUM(inID));
+        case INT4OID: return DatumGetInt32(PG_GETARG_DATUM(inID));
+        case INT2OID: return DatumGetInt16(PG_GETARG_DATUM(inID));
+        case BOOLOID: return DatumGetBool(PG_GETARG_DATUM(inID));
+    }
+    throw std::invalid_argument(
+        "Internal argument type does not match SQL argument type");
+}
+
+/**
+ * @internal For immutable arrays, the only allocation left is the memory
+ *     handle.
+ *
+ *     DOUBLE PRECISION[] and INTEGER[] arguments may be empty, as are the
+ *     indices and values of a sparse row without non-zero elements.
+ */
+Array_const<double> PGValue<FunctionCallInfo>::getAsByID(unsigned int inID,
+    Array_const<double>*) const {
+    
+    ArrayType *pgArray = getArrayByID(inID, FLOAT8OID, true);
+    return Array_const<double>(MemHandleSPtr(new PGArrayHandle(pgArray)),
+        boost::extents[ arrayLength(pgArray) ]);
+}
+
+Array_const<float> PGValue<FunctionCallInfo>::getAsByID(unsigned int inID,
+    Array_const<float>*) const {
+    
+    ArrayType *pgArray = getArrayByID(inID, FLOAT4OID);
+    return Array_const<float>(MemHandleSPtr(new PGArrayHandle(pgArray)),
+        boost::extents[ ARR_DIMS(pgArray)[0] ]);
+}
+
+Array_const<int32_t> PGValue<FunctionCallInfo>::getAsByID(unsigned int inID,
+    Array_const<int32_t>*) const {
+    
+    ArrayType *pgArray = getArrayByID(inID, INT4OID, true);
+    return Array_const<int32_t>(MemHandleSPtr(new PGArrayHandle(pgArray)),
+        boost::extents[ arrayLength(pgArray) ]);
+}
+
+DoubleCol_const PGValue<FunctionCallInfo>::getAsByID(unsigned int inID,
+    DoubleCol_const*) const {
+    
+    ArrayType *pgArray = getArrayByID(inID, FLOAT8OID);
+    return DoubleCol_const(MemHandleSPtr(new PGArrayHandle(pgArray)),
+        ARR_DIMS(pgArray)[0]);
+}
+
+DoubleRow_const PGValue<FunctionCallInfo>::getAsByID(unsigned int inID,
+    DoubleRow_const*) const {
+    
+    ArrayType *pgArray = getArrayByID(inID, FLOAT8OID);
+    return DoubleRow_const(MemHandleSPtr(new PGArrayHandle(pgArray)),
+        ARR_DIMS(pgArray)[0]);
+}
+
 AbstractValueSPtr PGValue<HeapTupleHeader>::getValueByID(unsigned int inID) const {
     if (mTuple == NULL)
         throw std::invalid_argument("Pointer to tuple data is invalid");
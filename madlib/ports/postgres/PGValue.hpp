@@ -11,6 +11,7 @@
 
 #include <madlib/ports/postgres/postgres.hpp>
 #include <madlib/ports/postgres/AbstractPGValue.hpp>
+#include <madlib/ports/postgres/PGCallSiteCache.hpp>
 
 extern "C" {
     #include <fmgr.h>           // for FunctionCallInfo
@@ -36,6 +37,13 @@ public:
     PGValue<FunctionCallInfo>(const FunctionCallInfo inFCinfo)
         : fcinfo(inFCinfo) { }
     
+    /**
+     * @brief Return the number of arguments of the function call
+     */
+    unsigned int size() const {
+        return fcinfo == NULL ? 0 : PG_NARGS();
+    }
+    
 protected:
     AbstractValueSPtr getValueByID(unsigned int inID) const;
     
@@ -43,7 +51,26 @@ protected:
         return AbstractValueSPtr( new PGValue<FunctionCallInfo>(*this) );
     }
     
+    // Conversions that read the argument directly from fcinfo, without
+    // creating an intermediate ConcreteValue
+    using AbstractValue::getAsByID;
+    bool getAsByID(unsigned int inID, bool*) const;
+    int32_t getAsByID(unsigned int inID, int32_t*) const;
+    int64_t getAsByID(unsigned int inID, int64_t*) const;
+    double getAsByID(unsigned int inID, double*) const;
+    Array_const<double> getAsByID(unsigned int inID, Array_const<double>*) const;
+    Array_const<float> getAsByID(unsigned int inID, Array_const<float>*) const;
+    Array_const<int32_t> getAsByID(unsigned int inID, Array_const<int32_t>*)
+        const;
+    DoubleCol_const getAsByID(unsigned int inID, DoubleCol_const*) const;
+    DoubleRow_const getAsByID(unsigned int inID, DoubleRow_const*) const;
+    
 private:
+    const PGCallSiteCache::Argument &getArgumentByID(unsigned int inID) const;
+    Datum getArrayDatumByID(unsigned int inID) const;
+    ArrayType *getArrayByID(unsigned int inID, Oid inElementTypeID,
+        bool inAllowEmpty = false) const;
+    
     /**
      * The name is chosen so that PostgreSQL macros like PG_NARGS can be
      * used.
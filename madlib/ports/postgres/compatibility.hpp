@@ -38,6 +38,14 @@ int AggCheckCallContext(FunctionCallInfo fcinfo, MemoryContext *aggcontext);
 
 #endif // PG_VERSION_NUM < 90000
 
+/*
+ * VARATT_IS_EXTERNAL_ONDISK was introduced together with indirect TOAST
+ * pointers in PostgreSQL 9.4. Before, every external value was stored on disk.
+ */
+#ifndef VARATT_IS_EXTERNAL_ONDISK
+    #define VARATT_IS_EXTERNAL_ONDISK(PTR) VARATT_IS_EXTERNAL(PTR)
+#endif
+
 } // namespace postgres
 
 } // namespace ports
@@ -10,6 +10,7 @@
 #define MADLIB_POSTGRES_MAIN_HPP
 
 #include <madlib/ports/postgres/postgres.hpp>
+#include <madlib/ports/postgres/PGArena.hpp>
 #include <madlib/ports/postgres/PGToDatumConverter.hpp>
 #include <madlib/ports/postgres/PGInterface.hpp>
 #include <madlib/ports/postgres/PGValue.hpp>
@@ -31,19 +32,23 @@ inline static Datum call(
     PG_FUNCTION_ARGS) {
 //template <AnyValue f(AbstractDBInterface &, AnyValue)>
 //inline Datum call(PG_FUNCTION_ARGS) {
-    int sqlerrcode;
+    int sqlerrcode = 0;
     char msg[256];
-    Datum datum;
+    Datum datum = 0;
+    bool resultIsNull = false;
 
+    // Small C++ objects created during this call are allocated in the arena
+    // (if operator new is overridden). They must not be used after leave().
+    // In particular, exception messages are copied to msg before.
+    unsigned int arenaDepth = PGArena::enter();
     try {
         PGInterface db(fcinfo);
         AnyValue result = f(db, PGValue<FunctionCallInfo>(fcinfo));
 
         if (result.isNull())
-            PG_RETURN_NULL();
-        
-        datum = PGToDatumConverter(fcinfo, result);
-        return datum;
+            resultIsNull = true;
+        else
+            datum = PGToDatumConverter(fcinfo, result);
     } catch (std::exception &exc) {
         sqlerrcode = ERRCODE_INVALID_PARAMETER_VALUE;
         strncpy(msg, exc.what(), sizeof(msg));
@@ -54,6 +59,14 @@ inline static Datum call(
             "debugging session.",
             sizeof(msg));
     }
+    PGArena::leave(arenaDepth);
+    
+    if (sqlerrcode == 0) {
+        if (resultIsNull)
+            PG_RETURN_NULL();
+        
+        return datum;
+    }
     
     // This code will only be reached in case of error.
     // We want to ereport only here, with only POD (plain old data) left on the
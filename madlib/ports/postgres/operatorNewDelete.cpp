@@ -7,8 +7,10 @@
  *//* ----------------------------------------------------------------------- */
 
 #include <madlib/ports/postgres/PGAllocator.hpp>
+#include <madlib/ports/postgres/PGArena.hpp>
 
 using madlib::ports::postgres::PGAllocator;
+using madlib::ports::postgres::PGArena;
 
 /**
  * The default allocator used by operator new and operator delete. It is not
@@ -27,7 +29,8 @@ static PGAllocator sDefaultAllocator;
  * that size.
  */
 void *operator new(std::size_t size) throw (std::bad_alloc) {
-    return sDefaultAllocator.allocate(size);
+    void *ptr = PGArena::allocate(size);
+    return ptr != NULL ? ptr : sDefaultAllocator.allocate(size);
 }
 
 /*
@@ -43,10 +46,12 @@ void *operator new(std::size_t size) throw (std::bad_alloc) {
 
 /**
  * The deallocation function (3.7.3.2) called by a delete-expression to render
- * the value of ptr invalid.
+ * the value of ptr invalid. Objects in the arena are released all at once by
+ * PGArena::leave().
  */
 void operator delete(void *ptr) throw() {
-    sDefaultAllocator.free(ptr);
+    if (!PGArena::contains(ptr))
+        sDefaultAllocator.free(ptr);
 }
 
 /**
@@ -55,12 +60,14 @@ void operator delete(void *ptr) throw() {
  * indication, instead of a bad_alloc exception.
  */
 void *operator new(std::size_t size, const std::nothrow_t &ignored) throw() {
-    return sDefaultAllocator.allocate(size, ignored);
+    void *ptr = PGArena::allocate(size);
+    return ptr != NULL ? ptr : sDefaultAllocator.allocate(size, ignored);
 }
 
 /**
  * Same as above.
  */
 void operator delete(void *ptr, const std::nothrow_t&) throw() {
-    sDefaultAllocator.free(ptr);
+    if (!PGArena::contains(ptr))
+        sDefaultAllocator.free(ptr);
 }
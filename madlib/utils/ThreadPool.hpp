@@ -0,0 +1,199 @@
+/* ----------------------------------------------------------------------- *//**
+ *
+ * @file ThreadPool.hpp
+ *
+ * @brief Fork-join thread pool that is safe to use inside a database backend
+ *
+ *//* ----------------------------------------------------------------------- */
+
+#ifndef MADLIB_THREADPOOL_HPP
+#define MADLIB_THREADPOOL_HPP
+
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+
+namespace madlib {
+
+namespace utils {
+
+/**
+ * @brief Fork-join thread pool for pure number crunching
+ *
+ * The database backend is single-threaded, so worker threads have to follow
+ * strict rules:
+ * - Workers must neither call into the backend nor allocate memory. In
+ *   particular, operator new must not be used, because it is implemented with
+ *   palloc. All buffers have to be allocated by the calling thread before
+ *   run() is called.
+ * - Workers must not throw exceptions.
+ * - Workers block all signals, so that the signal handlers of the backend
+ *   always run in the main thread.
+ *
+ * The calling thread takes part in the computation as part 0. If fewer worker
+ * threads could be started than requested, the pool simply has fewer parts.
+ * All threads are joined in the destructor, so a ThreadPool should only live
+ * as long as the function that uses it.
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief A task is called once for each part with
+     *     <tt>0 <= inPart < inNumParts</tt>
+     */
+    typedef void (*Task)(void *inContext, unsigned int inPart,
+        unsigned int inNumParts);
+
+    enum { kMaxNumThreads = 16 };
+
+    ThreadPool(unsigned int inNumThreads)
+        : mNumThreads(1), mIsSynchronized(false), mTask(NULL),
+          mContext(NULL), mGeneration(0), mNumPending(0), mShutdown(false) {
+
+        if (inNumThreads > kMaxNumThreads)
+            inNumThreads = kMaxNumThreads;
+        if (inNumThreads <= 1)
+            return;
+
+        pthread_mutex_init(&mMutex, NULL);
+        pthread_cond_init(&mWorkReady, NULL);
+        pthread_cond_init(&mWorkDone, NULL);
+        mIsSynchronized = true;
+
+        // Threads inherit the signal mask of the creating thread
+        sigset_t allSignals, oldSignals;
+        sigfillset(&allSignals);
+        pthread_sigmask(SIG_SETMASK, &allSignals, &oldSignals);
+        for (unsigned int i = 1; i < inNumThreads; i++) {
+            mWorkers[i].pool = this;
+            mWorkers[i].part = i;
+            if (pthread_create(&mWorkers[i].thread, NULL, workerMain,
+                &mWorkers[i]) != 0)
+                break;
+            mNumThreads++;
+        }
+        pthread_sigmask(SIG_SETMASK, &oldSignals, NULL);
+    }
+
+    ~ThreadPool() {
+        if (!mIsSynchronized)
+            return;
+
+        pthread_mutex_lock(&mMutex);
+        mShutdown = true;
+        pthread_cond_broadcast(&mWorkReady);
+        pthread_mutex_unlock(&mMutex);
+
+        for (unsigned int i = 1; i < mNumThreads; i++)
+            pthread_join(mWorkers[i].thread, NULL);
+
+        pthread_cond_destroy(&mWorkDone);
+        pthread_cond_destroy(&mWorkReady);
+        pthread_mutex_destroy(&mMutex);
+    }
+
+    /**
+     * @brief Number of parts that a task is split into
+     */
+    unsigned int size() const {
+        return mNumThreads;
+    }
+
+    /**
+     * @brief Run all parts of a task and return when they are finished
+     */
+    void run(Task inTask, void *inContext) {
+        if (mNumThreads <= 1) {
+            inTask(inContext, 0, 1);
+            return;
+        }
+
+        pthread_mutex_lock(&mMutex);
+        mTask = inTask;
+        mContext = inContext;
+        mNumPending = mNumThreads - 1;
+        mGeneration++;
+        pthread_cond_broadcast(&mWorkReady);
+        pthread_mutex_unlock(&mMutex);
+
+        inTask(inContext, 0, mNumThreads);
+
+        pthread_mutex_lock(&mMutex);
+        while (mNumPending > 0)
+            pthread_cond_wait(&mWorkDone, &mMutex);
+        pthread_mutex_unlock(&mMutex);
+    }
+
+    /**
+     * @brief Return the number of online processors, or 1 if unknown
+     */
+    static unsigned int numProcessors() {
+        long numProcessors = sysconf(_SC_NPROCESSORS_ONLN);
+        return numProcessors > 0 ? static_cast<unsigned int>(numProcessors) : 1;
+    }
+
+private:
+    struct Worker {
+        Worker() : pool(NULL), part(0) { }
+
+        ThreadPool *pool;
+        unsigned int part;
+        pthread_t thread;
+    };
+
+    static void *workerMain(void *inWorker) {
+        Worker &worker = *static_cast<Worker*>(inWorker);
+        ThreadPool &pool = *worker.pool;
+        unsigned long generation = 0;
+
+        pthread_mutex_lock(&pool.mMutex);
+        while (true) {
+            while (!pool.mShutdown && pool.mGeneration == generation)
+                pthread_cond_wait(&pool.mWorkReady, &pool.mMutex);
+            if (pool.mShutdown)
+                break;
+
+            generation = pool.mGeneration;
+            Task task = pool.mTask;
+            void *context = pool.mContext;
+            unsigned int numParts = pool.mNumThreads;
+            pthread_mutex_unlock(&pool.mMutex);
+
+            task(context, worker.part, numParts);
+
+            pthread_mutex_lock(&pool.mMutex);
+            if (--pool.mNumPending == 0)
+                pthread_cond_signal(&pool.mWorkDone);
+        }
+        pthread_mutex_unlock(&pool.mMutex);
+        return NULL;
+    }
+
+    // Not copyable
+    ThreadPool(const ThreadPool &);
+    ThreadPool &operator=(const ThreadPool &);
+
+    unsigned int mNumThreads;
+    Worker mWorkers[kMaxNumThreads];
+
+    /**
+     * Whether the mutex and the condition variables have been initialized
+     */
+    bool mIsSynchronized;
+
+    pthread_mutex_t mMutex;
+    pthread_cond_t mWorkReady;
+    pthread_cond_t mWorkDone;
+
+    Task mTask;
+    void *mContext;
+    unsigned long mGeneration;
+    unsigned int mNumPending;
+    bool mShutdown;
+};
+
+} // namespace utils
+
+} // namespace madlib
+
+#endif
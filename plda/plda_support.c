@@ -22,6 +22,7 @@
 #include "utils/lsyscache.h"
 #include "executor/executor.h"
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 PG_MODULE_MAGIC;
@@ -180,6 +181,69 @@ static int32 sampleTopic
 	return ret;
 }
 
+/* Before PostgreSQL 9.4, every external value was stored on disk. */
+#ifndef VARATT_IS_EXTERNAL_ONDISK
+#define VARATT_IS_EXTERNAL_ONDISK(PTR) VARATT_IS_EXTERNAL(PTR)
+#endif
+
+/**
+ * Cache of the last toasted value of an argument, kept in fn_extra. raw is a
+ * copy of the value as passed (for a value stored out of line on disk, just
+ * the TOAST pointer), detoasted is its expanded form.
+ */
+typedef struct {
+	struct varlena * raw;
+	struct varlena * detoasted;
+} DetoastCache;
+
+/**
+ * Returns an array argument, detoasting it only if it differs from the one
+ * of the previous call. The word-topic count matrix is the same for every
+ * document, so without the cache, a toasted matrix would be expanded once
+ * per document. The returned array must not be modified or returned.
+ *
+ * Only on-disk TOAST pointers and inline compressed values are cached.
+ * Indirect and expanded pointers (e.g., a plpgsql variable) merely hold a
+ * memory address, which may be reused for a different value.
+ */
+static ArrayType * getArrayArgCached(FunctionCallInfo fcinfo, int argno)
+{
+	struct varlena * raw = (struct varlena *)
+		DatumGetPointer(PG_GETARG_DATUM(argno));
+	DetoastCache * cache;
+	MemoryContext oldcontext;
+	Size rawsize;
+
+	if (!VARATT_IS_EXTERNAL_ONDISK(raw) && !VARATT_IS_COMPRESSED(raw))
+		return PG_GETARG_ARRAYTYPE_P(argno);
+
+	cache = (DetoastCache *)fcinfo->flinfo->fn_extra;
+	if (cache == NULL) {
+		cache = (DetoastCache *)MemoryContextAllocZero(
+			fcinfo->flinfo->fn_mcxt, sizeof(DetoastCache));
+		fcinfo->flinfo->fn_extra = cache;
+	}
+
+	rawsize = VARSIZE_ANY(raw);
+	if (cache->raw != NULL && VARSIZE_ANY(cache->raw) == rawsize &&
+	    memcmp(cache->raw, raw, rawsize) == 0)
+		return (ArrayType *)cache->detoasted;
+
+	if (cache->raw != NULL) {
+		pfree(cache->raw);
+		pfree(cache->detoasted);
+		cache->raw = NULL;
+	}
+
+	oldcontext = MemoryContextSwitchTo(fcinfo->flinfo->fn_mcxt);
+	cache->detoasted = pg_detoast_datum(raw);
+	cache->raw = (struct varlena *)palloc(rawsize);
+	memcpy(cache->raw, raw, rawsize);
+	MemoryContextSwitchTo(oldcontext);
+
+	return (ArrayType *)cache->detoasted;
+}
+
 /**
  * This function assigns a topic to each word in a document using the count
  * statistics obtained so far on the corpus. The function returns an array
@@ -196,7 +260,7 @@ Datum sampleNewTopics(PG_FUNCTION_ARGS)
 	ArrayType * doc_arr = PG_GETARG_ARRAYTYPE_P(0);
 	ArrayType * topics_arr = PG_GETARG_ARRAYTYPE_P(1);
 	ArrayType * topic_d_arr = PG_GETARG_ARRAYTYPE_P(2);
-	ArrayType * global_count_arr = PG_GETARG_ARRAYTYPE_P(3);
+	ArrayType * global_count_arr = getArrayArgCached(fcinfo, 3);
 	ArrayType * topic_counts_arr = PG_GETARG_ARRAYTYPE_P(4);
 	int32 num_topics = PG_GETARG_INT32(5);
 	int32 dsize = PG_GETARG_INT32(6);